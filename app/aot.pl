@@ -0,0 +1,271 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           https://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(app_aot, []).
+
+/** <module> Ahead-of-time compilation of Prolog files to shared objects
+
+This _app_ compiles a Prolog source file  into a shared object that can
+be loaded using use_foreign_library/1, e.g.
+
+    swipl aot -o rules.so rules.pl
+
+and, in the deployed application
+
+    :- use_foreign_library('rules.so').
+
+The shared object embeds the  VM  code   of  the  file, compiled with the
+Prolog flag `optimise` set to `true`,  in   the  QLF  format. Loading it
+installs the predicates without  reading  or   compiling  the  source. As
+the result is normal clause code, the  debugger works as usual (inlined
+calls are executed as normal calls   while debugging) and reconsulting the
+source replaces the precompiled definitions.
+
+The C code is compiled using `swipl-ld`. Using `--c` only the C file is
+generated, which allows building it  using   other  tools. The CMake file
+`swipl.cmake` provides swipl_aot(target  source)   to  do  this  from a
+CMake project.
+*/
+
+:- use_module(library(main)).
+:- use_module(library(option)).
+:- use_module(library(readutil)).
+:- use_module(library(apply)).
+:- use_module(library(lists)).
+:- use_module(library(utf8), [utf8_codes//1]).
+:- if(exists_source(library(process))).
+:- use_module(library(process)).
+:- endif.
+
+:- initialization(main, main).
+
+opt_type(o,        output,   file(write)).
+opt_type(output,   output,   file(write)).
+opt_type(c,        c,        boolean).
+opt_type(optimise, optimise, boolean).
+
+opt_help(help(usage),
+         " [option ...] file").
+opt_help(help(header),
+         [ansi(bold, "Compile a Prolog file into a loadable shared object.", [])]).
+opt_help(output,
+         "Output file (default <file>.so or <file>.c using --c)").
+opt_help(c,
+         "Only generate the C source").
+opt_help(optimise,
+         "Compile with the optimise flag (default true)").
+
+main(Argv) :-
+    argv_options(Argv, Positional, Options),
+    (   Positional = [File]
+    ->  aot(File, Options)
+    ;   argv_usage(debug),
+        halt(1)
+    ).
+
+%!  aot(+File, +Options) is det.
+%
+%   Compile File into a shared object or C file.
+
+aot(File, Options) :-
+    absolute_file_name(File, Source,
+                       [ file_type(prolog),
+                         access(read)
+                       ]),
+    option(c(COnly), Options, false),
+    output_file(Source, COnly, Output, Options),
+    option(optimise(Optimise), Options, true),
+    setup_call_cleanup(
+        tmp_file(aot, Tmp),
+        aot(Source, Tmp, Output, COnly, Optimise),
+        delete_tmp(Tmp)).
+
+%   The QLF data is loaded as Source.  QLF loading relocates the source
+%   paths if the directory of the loaded file differs from that of the
+%   QLF file recorded in the header.  We write the data to Tmp, but
+%   record a QLF file in the directory of Source.
+
+aot(Source, Tmp, Output, COnly, Optimise) :-
+    file_name_extension(Tmp, qlf, Qlf),
+    file_name_extension(SourceBase, _, Source),
+    file_name_extension(SourceBase, qlf, SourceQlf),
+    load_files(user:Source,
+               [ '$qlf'(Qlf),
+                 '$qlf_as'(SourceQlf),
+                 optimise(Optimise)
+               ]),
+    read_file_to_codes(Qlf, Bytes, [type(binary)]),
+    (   COnly == true
+    ->  CFile = Output
+    ;   file_name_extension(Tmp, c, CFile)
+    ),
+    file_name_extension(Base, _, Output),
+    file_base_name(Base, Name),
+    setup_call_cleanup(
+        open(CFile, write, Out, [encoding(utf8)]),
+        write_c(Out, Source, Name, Bytes),
+        close(Out)),
+    (   COnly == true
+    ->  true
+    ;   swipl_ld(CFile, Output)
+    ).
+
+output_file(_Source, _COnly, Output, Options) :-
+    option(output(Output), Options),
+    !.
+output_file(Source, COnly, Output, _Options) :-
+    file_name_extension(Base, _, Source),
+    (   COnly == true
+    ->  Ext = c
+    ;   current_prolog_flag(shared_object_extension, Ext)
+    ),
+    file_name_extension(Base, Ext, Output0),
+    file_base_name(Output0, Output).
+
+delete_tmp(Tmp) :-
+    forall(( member(Ext, [qlf, c, o]),
+             file_name_extension(Tmp, Ext, File),
+             exists_file(File)
+           ),
+           delete_file(File)).
+
+%!  write_c(+Out, +Source, +Name, +Bytes) is det.
+%
+%   Write the C file that embeds the QLF data in Bytes and loads it from
+%   the install function of the shared object.
+
+write_c(Out, Source, Name, Bytes) :-
+    install_function(Name, Install),
+    format(Out, '/*  Generated by "swipl aot" from ~w.  Do not edit.~n\c
+                 */~n~n', [Source]),
+    format(Out, '#include <SWI-Stream.h>~n\c
+                 #include <SWI-Prolog.h>~n~n', []),
+    format(Out, 'static const unsigned char aot_qlf[] =~n{ ', []),
+    write_bytes(Bytes, 0, Out),
+    format(Out, '~n};~n~n', []),
+    format(Out, 'install_t~n~w(void)~n', [Install]),
+    format(Out, '{ IOSTREAM *in = Sopen_string(NULL, (char*)aot_qlf,~n\c
+                 \t\t\t\tsizeof(aot_qlf), "r");~n', []),
+    format(Out, '  fid_t fid = PL_open_foreign_frame();~n\c
+                 \x20 term_t av = PL_new_term_refs(2);~n\c
+                 \x20 term_t s = PL_new_term_ref();~n~n', []),
+    format(Out, '  if ( in && fid &&~n\c
+                 \x20      PL_unify_stream(s, in) &&~n\c
+                 \x20      PL_put_chars(av+0, PL_ATOM|REP_UTF8, (size_t)-1,~n\c
+                 \t\t    "', []),
+    c_string(Out, Source),
+    format(Out, '") &&~n\c
+                 \x20      PL_unify_term(av+1,~n\c
+                 \t\t     PL_LIST, 2,~n\c
+                 \t\t       PL_FUNCTOR_CHARS, "stream", 1, PL_TERM, s,~n\c
+                 \t\t       PL_FUNCTOR_CHARS, "format", 1, PL_CHARS, "qlf") )~n\c
+                 \x20   PL_call_predicate(NULL, PL_Q_NORMAL,~n\c
+                 \t\t      PL_predicate("load_files", 2, "system"), av);~n~n', []),
+    format(Out, '  if ( in )~n\c
+                 \x20   Sclose(in);~n\c
+                 \x20 if ( fid )~n\c
+                 \x20   PL_close_foreign_frame(fid);~n}~n', []).
+
+%!  install_function(+Name, -Function) is det.
+%
+%   load_foreign_library/1 first tries   install_<name>()  and  then
+%   install().
+
+install_function(Name, Install) :-
+    atom_codes(Name, [H|T]),
+    code_type(H, csymf),
+    forall(member(C, T), code_type(C, csym)),
+    !,
+    atom_concat(install_, Name, Install).
+install_function(_, install).
+
+write_bytes([], _, _).
+write_bytes([H|T], I, Out) :-
+    format(Out, '0x~|~`0t~16r~2+', [H]),
+    (   T == []
+    ->  true
+    ;   I1 is I+1,
+        (   I1 mod 12 =:= 0
+        ->  format(Out, ',~n  ', [])
+        ;   format(Out, ',', [])
+        ),
+        write_bytes(T, I1, Out)
+    ).
+
+%!  c_string(+Out, +Atom) is det.
+%
+%   Write Atom as the content of a C string literal holding UTF-8.
+
+c_string(Out, Atom) :-
+    atom_codes(Atom, Codes),
+    phrase(utf8_codes(Codes), Bytes),
+    maplist(c_char(Out), Bytes).
+
+c_char(Out, C) :-
+    (   C >= 0'\s, C < 127, C \== 0'", C \== 0'\\, C \== 0'?
+    ->  put_char(Out, C)
+    ;   format(Out, '\\~|~`0t~8r~3+', [C])
+    ).
+
+%!  swipl_ld(+CFile, +Output) is det.
+%
+%   Compile and link CFile using `swipl-ld` from the same installation.
+
+swipl_ld(_CFile, _Output) :-
+    \+ current_predicate(process_create/3),
+    !,
+    format(user_error,
+           'swipl aot: library(process) is not available.  \c
+            Use --c and compile the C file yourself~n', []),
+    halt(1).
+swipl_ld(CFile, Output) :-
+    current_prolog_flag(executable, Exe),
+    file_directory_name(Exe, Dir),
+    atom_concat(Dir, '/swipl-ld', Ld0),
+    (   current_prolog_flag(windows, true)
+    ->  file_name_extension(Ld0, exe, Ld)
+    ;   Ld = Ld0
+    ),
+    process_create(Ld,
+                   [ '-pl', file(Exe), '-shared',
+                     '-o', file(Output), file(CFile)
+                   ],
+                   [ process(Pid)
+                   ]),
+    process_wait(Pid, Status),
+    (   Status == exit(0)
+    ->  true
+    ;   format(user_error, 'swipl-ld failed: ~p~n', [Status]),
+        halt(1)
+    ).
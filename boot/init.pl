@@ -383,6 +383,7 @@ det(Spec)                :- '$set_pattr'(Spec, pred, det(true)).
     call_cleanup(0,0),
     catch_with_backtrace(0,?,0),
     notrace(0),
+    '$recover_and_rethrow'(0, +),
     '$meta_call'(0).
 
 :- '$iso'((call/1, (\+)/1, once/1, (;)/2, (',')/2, (->)/2, catch/3)).
@@ -2702,7 +2703,11 @@ load_files(Module:Files, Options) :-
 
 %!  '$qdo_load_file'(+Spec, +FullFile, +ContextModule, +Options) is det.
 %
-%   Switch to qcompile mode if requested by the option '$qlf'(+Out)
+%   Switch to qcompile mode if requested by the option '$qlf'(+Out).
+%   The option '$qlf_as'(+File) records File  rather than Out as the
+%   path of the QLF file.  This  is  used  by  `swipl  aot`,  which
+%   writes QLF data to a temporary file that is loaded as if it was
+%   in the directory of the source.
 
 '$qdo_load_file'(File, FullFile, Module, Options) :-
     '$qdo_load_file2'(File, FullFile, Module, Action, Options),
@@ -2713,8 +2718,12 @@ load_files(Module:Files, Options) :-
     memberchk('$qlf'(QlfOut), Options),
     '$stage_file'(QlfOut, StageQlf),
     !,
+    (   memberchk('$qlf_as'(QlfAs), Options)
+    ->  true
+    ;   QlfAs = StageQlf
+    ),
     setup_call_catcher_cleanup(
-	'$qstart'(StageQlf, Module, State),
+	'$qstart'(StageQlf, QlfAs, Module, State),
 	( '$do_load_file'(File, FullFile, Module, Action, Options),
           '$qlf_add_dependencies'(FullFile)
         ),
@@ -2723,8 +2732,8 @@ load_files(Module:Files, Options) :-
 '$qdo_load_file2'(File, FullFile, Module, Action, Options) :-
     '$do_load_file'(File, FullFile, Module, Action, Options).
 
-'$qstart'(Qlf, Module, state(OldMode, OldModule)) :-
-    '$qlf_open'(Qlf),
+'$qstart'(Qlf, QlfAs, Module, state(OldMode, OldModule)) :-
+    '$qlf_open'(Qlf, QlfAs),
     '$compilation_mode'(OldMode, qlf),
     '$set_source_module'(OldModule, Module).
 
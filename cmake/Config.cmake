@@ -446,6 +446,9 @@ endif()
 if(VMI_FUNCTIONS)
   set(O_VMI_FUNCTIONS 1)
 endif()
+if(DIRECT_THREADING)
+  set(O_DIRECT_THREADING 1)
+endif()
 if(STATIC_EXTENSIONS)
   set(O_STATIC_EXTENSIONS 1)
 endif()
@@ -462,6 +465,9 @@ endif()
 if(VALIDATE_API)
   set(O_VALIDATE_API 1)
 endif()
+if(VMI_PAIR_STATS)
+  set(O_VMI_PAIR_STATS 1)
+endif()
 
 ################
 # Stuff we do not need to define is below such that findmacros.pl does
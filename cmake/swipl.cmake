@@ -19,6 +19,10 @@
 #
 #   - It provides a function swipl_add_test(name) that runs a
 #     test file from test/test_${name}.pl
+#
+#   - It provides a function swipl_aot(target source) that builds
+#     a module `target` holding the precompiled code of the Prolog
+#     file `source`.  See `swipl aot --help`.
 
 if("$ENV{SWIPL_PACK_VERSION}" EQUAL 2)
   set(swipl_home_dir   $ENV{SWIPL_HOME_DIR})
@@ -127,5 +131,17 @@ function(swipl_add_test name)
 	                    ${CMAKE_CURRENT_SOURCE_DIR}/test/test_${name}.pl)
 endfunction()
 
+function(swipl_aot target source)
+  get_filename_component(source ${source} ABSOLUTE)
+  set(csource ${CMAKE_CURRENT_BINARY_DIR}/${target}.c)
+  add_custom_command(
+      OUTPUT ${csource}
+      COMMAND ${SWIPL} aot --c -o ${csource} ${source}
+      DEPENDS ${source}
+      COMMENT "Compiling ${source} ahead of time")
+  add_library(${target} MODULE ${csource})
+  target_link_swipl(${target})
+endfunction()
+
 # Avoid message on unused variable
 set(SWIPL "${SWIPL}")
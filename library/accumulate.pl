@@ -0,0 +1,289 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           https://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(accumulate,
+          [ (accumulate)/1,
+            op(1150, fx, (accumulate))
+          ]).
+:- autoload(library(error),
+            [instantiation_error/1, must_be/2, domain_error/2]).
+:- autoload(library(lists), [append/3, member/2]).
+
+/** <module> Accumulator introduction for arithmetic recursion
+
+Predicates that compute a number by   combining  the result of recursive
+calls, such as
+
+    ==
+    :- use_module(library(accumulate)).
+
+    :- accumulate len/2 as (+).
+
+    len([], 0).
+    len([_|T], N) :- len(T, N0), N is N0+1.
+    ==
+
+are not tail recursive and need a   local  stack frame for each level of
+the recursion. The directive accumulate/1  declares that the last argument
+of the predicate is computed using  the   associative  and commutative
+operator `+` or `*`. The clauses are   compiled into a helper predicate
+that carries an accumulator:
+
+    ==
+    len(L, N) :- 'len acc'(L, 0, N).
+
+    'len acc'([], Acc, N) :- N is Acc+0.
+    'len acc'([_|T], Acc, N) :- Acc1 is Acc+1, 'len acc'(T, Acc1, N).
+    ==
+
+A clause is turned into a last call if its body ends with the recursive
+call followed by `Out is R0 Op E` or `Out is E Op R0`, where `R0` is the
+output of the recursive call and   `E`  does not depend on the recursive
+call. All other clauses compute their  result   as  before, which is then
+combined with the accumulator.
+
+Because the operations are  executed  in   a  different  order,  this
+transformation is only correct if the operator is associative for the
+values involved. This holds for integers   and rationals, but not exactly
+for floats, which is why it must be requested explicitly.
+*/
+
+:- multifile
+    system:term_expansion/2,
+    accumulate_declaration/3.       % Head, Module, Op
+
+%!  accumulate(:Spec)
+%
+%   The declaration ``:- accumulate Name/Arity as Op, ...`` compiles the
+%   clauses of the predicates using an  accumulator   for  the  last
+%   argument. Op is one of `+` or `*`.   This  directive must precede
+%   all clauses of the predicate.
+
+accumulate(Spec) :-
+    throw(error(context_error(nodirective, accumulate(Spec)), _)).
+
+expand_accumulate_declaration(Spec, Clauses) :-
+    prolog_load_context(module, Module),
+    phrase(expand_specs(Spec, Module), Clauses).
+
+expand_specs(Var, _) -->
+    { var(Var),
+      !,
+      instantiation_error(Var)
+    }.
+expand_specs(M:Spec, _) -->
+    !,
+    expand_specs(Spec, M).
+expand_specs((A,B), Module) -->
+    !,
+    expand_specs(A, Module),
+    expand_specs(B, Module).
+expand_specs(PI as Op, Module) -->
+    { valid_pi(PI, Name, Arity),
+      valid_op(Op, Identity),
+      functor(GenHead, Name, Arity),
+      GenHead =.. [Name|Args],
+      append(In, [Out], Args),
+      acc_head(Name, In, Identity, Out, AccHead)
+    },
+    [ (accumulate):accumulate_declaration(GenHead, Module, Op),
+      Module:(GenHead :- AccHead)
+    ].
+expand_specs(Spec, _) -->
+    { domain_error(accumulate_specification, Spec) }.
+
+valid_pi(Name/Arity, Name, Arity) :-
+    must_be(atom, Name),
+    must_be(positive_integer, Arity).
+
+valid_op(Op, _) :-
+    var(Op),
+    !,
+    instantiation_error(Op).
+valid_op(+, 0) :- !.
+valid_op(*, 1) :- !.
+valid_op(Op, _) :-
+    domain_error(accumulate_operator, Op).
+
+acc_head(Name, In, Acc, Out, AccHead) :-
+    atom_concat(Name, ' acc', AccName),
+    append(In, [Acc, Out], AccArgs),
+    AccHead =.. [AccName|AccArgs].
+
+%!  acc_clause(+Clause, +Op, -AccClause) is det.
+%
+%   Translate a clause of the declared predicate.
+
+acc_clause((Head :- Body), Op, (AccHead :- AccBody)) :-
+    !,
+    Head =.. [Name|Args],
+    append(In, [Out], Args),
+    acc_head(Name, In, Acc, Result, AccHead),
+    (   last_call(Body, Name, In, Out, Op, Pre, RecIn, E)
+    ->  acc_head(Name, RecIn, Acc1, Result, RecGoal),
+        Step =.. [Op, Acc, E],
+        mkconj(Pre, (Acc1 is Step, RecGoal), AccBody)
+    ;   pass_call(Body, Name, In, Out, Pre, RecIn)
+    ->  acc_head(Name, RecIn, Acc, Result, RecGoal),
+        mkconj(Pre, RecGoal, AccBody)
+    ;   Step =.. [Op, Acc, Out],
+        mkconj(Body, Result is Step, AccBody)
+    ).
+acc_clause(Head, Op, AccClause) :-
+    acc_clause((Head :- true), Op, AccClause).
+
+mkconj(true, G, G) :- !.
+mkconj(G, true, G) :- !.
+mkconj(G1, G2, (G1,G2)).
+
+%!  last_call(+Body, +Name, +In, +Out, +Op,
+%!            -Pre, -RecIn, -E) is semidet.
+%
+%   True when Body is `Pre, Name(RecIn..., R0), Out is R0 Op E`, such
+%   that E may be evaluated before the recursive call.
+
+last_call(Body, Name, In, Out, Op, Pre, RecIn, E) :-
+    split_last(Body, Pre0, Rec, Is),
+    var(Out),
+    Is = (Out1 is Expr),
+    Out1 == Out,
+    Rec =.. [Name|RecArgs],
+    append(RecIn, [R0], RecArgs),
+    var(R0),
+    operand(Expr, Op, R0, E),
+    Pre = Pre0,
+    term_variables(E, EVars),
+    term_variables(RecIn, RecVars),
+    term_variables(In-Pre, Before),
+    \+ ( member(V, EVars),
+         memberchk_eq(V, RecVars),
+         \+ memberchk_eq(V, Before)
+       ),
+    occurrences(R0, Body, 2),
+    occurrences(R0, In, 0),
+    term_variables(In-Pre-RecIn-E, Vars),
+    \+ memberchk_eq(Out, Vars).
+
+%!  pass_call(+Body, +Name, +In, +Out, -Pre, -RecIn) is semidet.
+%
+%   True when Body is `Pre, Name(RecIn..., Out)`, i.e., the result of
+%   the recursive call is our result.
+
+pass_call(Body, Name, In, Out, Pre, RecIn) :-
+    var(Out),
+    (   Body = (_,_)
+    ->  split_last(Body, Pre1, Goal1, Rec),
+        mkconj(Pre1, Goal1, Pre)
+    ;   Pre = true,
+        Rec = Body
+    ),
+    Rec =.. [Name|RecArgs],
+    append(RecIn, [Out1], RecArgs),
+    Out1 == Out,
+    term_variables(In-Pre-RecIn, Vars),
+    \+ memberchk_eq(Out, Vars).
+
+operand(Expr, Op, R0, E) :-
+    Expr =.. [Op, A, B],
+    (   A == R0
+    ->  E = B
+    ;   B == R0
+    ->  E = A
+    ),
+    occurrences(R0, E, 0).
+
+split_last((A,B), Pre, Rec, Is) :-
+    !,
+    (   B = (_,_)
+    ->  split_last(B, Pre1, Rec, Is),
+        mkconj(A, Pre1, Pre)
+    ;   Pre = true,
+        Rec = A,
+        Is = B
+    ).
+
+%!  occurrences(+Var, +Term, ?Count) is semidet.
+%
+%   True when Var appears Count times in Term.
+
+occurrences(Var, Term, Count) :-
+    occurrences(Var, Term, 0, Count).
+
+occurrences(Var, Term, C0, C) :-
+    (   Var == Term
+    ->  C is C0+1
+    ;   compound(Term)
+    ->  compound_name_arity(Term, _, Arity),
+        occurrences_args(1, Arity, Var, Term, C0, C)
+    ;   C = C0
+    ).
+
+occurrences_args(I, Arity, Var, Term, C0, C) :-
+    (   I > Arity
+    ->  C = C0
+    ;   arg(I, Term, A),
+        occurrences(Var, A, C0, C1),
+        I2 is I+1,
+        occurrences_args(I2, Arity, Var, Term, C1, C)
+    ).
+
+memberchk_eq(X, [Y|Ys]) :-
+    (   X == Y
+    ->  true
+    ;   memberchk_eq(X, Ys)
+    ).
+
+head(Var, _) :-
+    var(Var), !, fail.
+head((H:-_B), Head) :-
+    !,
+    head(H, Head).
+head(H, M:H) :-
+    callable(H),
+    H \= _:_,
+    prolog_load_context(module, M).
+
+
+                 /*******************************
+                 *        EXPANSION HOOKS       *
+                 *******************************/
+
+system:term_expansion((:- accumulate(Spec)), Clauses) :-
+    \+ current_prolog_flag(xref, true),
+    expand_accumulate_declaration(Spec, Clauses).
+system:term_expansion(Term, AccClause) :-
+    \+ current_prolog_flag(xref, true),
+    head(Term, Module:Head),
+    accumulate_declaration(Head, Module, Op),
+    acc_clause(Term, Op, AccClause).
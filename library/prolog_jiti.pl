@@ -38,14 +38,17 @@
           [ jiti_list/0,
             jiti_list/1,                % +Spec
             jiti_suggest_modes/1,       % :Spec
-            jiti_suggest_modes/0
+            jiti_suggest_modes/0,
+            jiti_advice/0,
+            jiti_advice/1               % +Options
           ]).
-:- autoload(library(apply), [maplist/2, foldl/4, convlist/3]).
+:- autoload(library(apply), [maplist/2, foldl/4, convlist/3, include/3]).
 :- autoload(library(dcg/basics), [number//1]).
 :- autoload(library(ansi_term), [ansi_format/3, ansi_hyperlink/3]).
 :- autoload(library(prolog_code), [pi_head/2, most_general_goal/2]).
 :- autoload(library(listing), [portray_clause/1]).
 :- autoload(library(lists), [append/2]).
+:- autoload(library(option), [option/2, option/3]).
 :- autoload(library(ordsets), [ord_subtract/3]).
 
 
@@ -93,6 +96,9 @@ by the system and can help diagnosing space and performance issues.
 %         as just-in-time indexes.
 %       - ``V`` denotes the index is _virtual_, i.e., it has not yet
 %         been materialized.
+%       - ``B`` denotes the index has a Bloom filter that rejects calls
+%         for which there is no matching clause.  It is followed by
+%         the estimated false positive rate of the filter.
 
 jiti_list :-
     jiti_list(_:_).
@@ -129,7 +135,7 @@ print_index(PredColW, PI0, Dict, N, N1) :-
       collisions:Collisions0} :< Dict,
     predicate_property(Head, number_of_clauses(CCount)),
     phrase(iarg_spec(Pos, Args), ArgsS),
-    phrase(iflags(List, R), Flags),
+    phrase(iflags(List, R, Dict), Flags),
     istyle(R, Style),
     icoll(R, List, Collisions0, Collisions),
     CCountColZ is PredColW+8,
@@ -179,12 +185,19 @@ deep_list([H|T]) -->
     deep_list(T).
 
 
-iflags(true, R)  ==> "L", irealised(R).
-iflags(false, R) ==> "", irealised(R).
+iflags(true, R, Dict)  ==> "L", irealised(R), ibloom(Dict).
+iflags(false, R, Dict) ==> "", irealised(R), ibloom(Dict).
 
 irealised(false) ==> "V".
 irealised(true)  ==> "".
 
+ibloom(Dict) -->
+    (   { get_dict(bloom, Dict, FPR) }
+    ->  { format(codes(Codes), 'B~1f%', [FPR*100]) },
+        Codes
+    ;   ""
+    ).
+
 istyle(true, code).
 istyle(false, comment).
 
@@ -293,6 +306,106 @@ set_any(_, _, _) =>
     true.
 
 
+                /*******************************
+                *            ADVICE            *
+                *******************************/
+
+%!  jiti_advice is det.
+%!  jiti_advice(+Options) is det.
+%
+%   Report the call modes that  most   often  scan the clauses of a
+%   predicate linearly or use a poor   index.  This requires sampling
+%   to be enabled using the Prolog flag `ci_sample` __before__ running
+%   the program, e.g.
+%
+%       ?- set_prolog_flag(ci_sample, 100).
+%       ?- run_my_program.
+%       ?- jiti_advice.
+%
+%   Modes are ranked by the estimated  number   of  clauses  that were
+%   visited.  Only predicates in user modules are reported and calls to
+%   predicates with few clauses are not sampled. The columns use the
+%   following notation:
+%
+%     - The `Mode` column lists the instantiated arguments of the
+%       sampled calls, using the same notation as jiti_list/1.
+%     - `Calls` and `Visits` are the estimated number of such calls and
+%       the estimated number of clauses visited by them.
+%     - `Index` is only shown if the option materialize(true) is given.
+%       It shows the index that was created for this mode or `-` if no
+%       index is worthwhile.
+%
+%   Options:
+%
+%     - top(+Count)
+%       Only report the Count worst modes.  Default is 20.
+%     - materialize(+Boolean)
+%       If `true`, create the index JITI would create for each reported
+%       mode.  Notably for static predicates whose candidate indexes
+%       are fixed, this may create indexes that are otherwise not
+%       considered.
+%     - clear(+Boolean)
+%       If `true`, delete the collected data after reporting.
+
+jiti_advice :-
+    jiti_advice([]).
+
+jiti_advice(Options) :-
+    option(clear(Clear), Options, false),
+    '$index_advice'(Advice0, Clear),
+    include(user_advice, Advice0, Advice),
+    (   Advice == []
+    ->  print_message(informational, jiti(no_advice))
+    ;   option(top(Top), Options, 20),
+        option(materialize(Materialize), Options, false),
+        sort(4, @>=, Advice, Ranked),      % advice(PI,Args,Calls,Visits,Clauses)
+        first_n(Top, Ranked, Report),
+        tty_width(TTYW),
+        PredColW is TTYW-47,
+        TableWidth is TTYW-1,
+        ansi_format(bold, 'Predicate~*|~w ~t~10+~w ~t~w~12+ ~t~w~14+ ~w~n',
+                    [PredColW, '#Clauses', 'Mode', 'Calls', 'Visits', 'Index']),
+        format('~`\u2015t~*|~n', [TableWidth]),
+        maplist(print_advice(PredColW, Materialize), Report)
+    ).
+
+user_advice(advice(M:_PI, _Args, _Calls, _Visits, _Clauses)) :-
+    module_property(M, class(user)).
+
+first_n(N, List, Prefix) :-
+    length(List, Len),
+    (   Len =< N
+    ->  Prefix = List
+    ;   length(Prefix, N),
+        append(Prefix, _, List)
+    ).
+
+print_advice(PredColW, Materialize,
+             advice(PI, Args, Calls, Visits, Clauses)) :-
+    phrase(plus_list(Args), ModeS),
+    advice_index(Materialize, PI, Args, IndexS),
+    CCountColZ is PredColW+8,
+    format_pi(PI),
+    format(' ~t~D~*|  ', [Clauses, CCountColZ]),
+    format('~|~s ~t~D~12+ ~t~D~14+ ~s~n',
+           [ModeS, Calls, Visits, IndexS]).
+
+advice_index(true, PI, Args, IndexS) :-
+    !,
+    pi_head(PI, M:Head0),
+    functor(Head0, Name, Arity),
+    functor(Head, Name, Arity),
+    maplist(bind_arg(Head), Args),
+    (   '$jiti_add_index'(M:Head, IArgs)
+    ->  phrase(plus_list(IArgs), IndexS)
+    ;   IndexS = "-"
+    ).
+advice_index(_, _, _, "").
+
+bind_arg(Head, Arg) :-
+    arg(Arg, Head, []).
+
+
                 /*******************************
                 *      SPECIFY PREDICATES      *
                 *******************************/
@@ -325,6 +438,8 @@ tty_width(80).
 
 :- multifile prolog:message//1.
 
+prolog:message(jiti(no_advice)) -->
+    [ 'No index advice.  Did you set the flag ci_sample?' ].
 prolog:message(jiti(no_modes(M:Head))) -->
     { var(Head) },
     [ 'No mode suggestions for predicates in module ~p'-[M] ].
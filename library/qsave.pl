@@ -98,6 +98,8 @@ save_option(foreign,     qsave_foreign_option,
             "Include foreign code in state").
 save_option(obfuscate,   boolean,
             "Obfuscate identifiers").
+save_option(perfect_hash, boolean,
+            "Save perfect hash indexes for static predicates").
 save_option(verbose,     boolean,
             "Be more verbose about the state creation").
 save_option(undefined,   oneof([ignore,error]),
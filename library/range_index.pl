@@ -0,0 +1,110 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(range_index,
+          [ range_call/4                % :Goal, +Arg, ?Low, ?High
+          ]).
+:- autoload(library(error), [must_be/2, existence_error/2]).
+:- autoload(library(lists), [member/2]).
+
+:- meta_predicate
+    range_call(0, +, ?, ?).
+
+/** <module> Call predicates using an ordered index
+
+This module provides range_call/4, which   enumerates  the solutions of a
+goal for which some argument is  in  a   given  range  of  the standard
+order of terms. Where just-in-time indexing (JITI)   only helps if this
+argument is bound, range_call/4 uses an _ordered_ index on the argument
+that allows finding the matching clauses  without scanning all clauses.
+For example, given a large table price/2, the goal below finds all items
+with a price between 100 and 200:
+
+```
+?- range_call(price(Item, Price), 2, 100, 200).
+```
+
+The ordered index is created on  the   first  call and remains valid as
+long as the predicate is not modified. Numbers and atoms are ordered.
+Clauses that have a variable or other   term  at the indexed argument
+are always tried.
+*/
+
+%!  range_call(:Goal, +Arg, ?Low, ?High) is nondet.
+%
+%   True when Goal is true and   the  Arg-th argument of Goal satisfies
+%   `Low @=< Value, Value @=< High`. If Low or High is unbound the range
+%   has no lower or upper limit.  Solutions are enumerated in the order
+%   of the value of the argument.   Clauses  for which this argument is
+%   not an atom or number in the clause head are tried last.
+%
+%   Goal must be a call to a   predicate defined by clauses. The clause
+%   bodies are executed using call/1, which  implies that a cut in the
+%   body is local to the  clause.   This  predicate  is intended for
+%   (large) fact tables.
+%
+%   @error existence_error(procedure, PI) if Goal is undefined.
+%   @error permission_error(access, private_procedure, PI) if Goal
+%   is a foreign predicate.
+
+range_call(M:Goal, Arg, Low, High) :-
+    must_be(callable, Goal),
+    must_be(positive_integer, Arg),
+    (   '$define_predicate'(M:Goal)
+    ->  true
+    ;   functor(Goal, Name, Arity),
+        existence_error(procedure, M:Name/Arity)
+    ),
+    '$clause_range'(M:Goal, Arg, Low, High, Refs),
+    arg(Arg, Goal, Value),
+    member(Ref, Refs),
+    clause(Head, Body, Ref),
+    Head = CM:Goal,
+    call_body(Body, CM),
+    in_range(Low, Value, High).
+
+call_body(true, _) :-
+    !.
+call_body(Body, M) :-
+    call(M:Body).
+
+in_range(Low, Value, High) :-
+    (   var(Low)
+    ->  true
+    ;   Low @=< Value
+    ),
+    (   var(High)
+    ->  true
+    ;   Value @=< High
+    ).
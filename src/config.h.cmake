@@ -1,5 +1,6 @@
 #cmakedefine __CONDA__ @__CONDA__@
 #cmakedefine O_VMI_FUNCTIONS @O_VMI_FUNCTIONS@
+#cmakedefine O_DIRECT_THREADING @O_DIRECT_THREADING@
 #cmakedefine AC_APPLE_UNIVERSAL_BUILD @AC_APPLE_UNIVERSAL_BUILD@
 #cmakedefine ALIGNOF_DOUBLE @ALIGNOF_DOUBLE@
 #cmakedefine ALIGNOF_INT64_T @ALIGNOF_INT64_T@
@@ -309,6 +310,7 @@
 #cmakedefine O_GMP @O_GMP@
 #cmakedefine O_BF @O_BF@
 #cmakedefine O_VALIDATE_API @O_VALIDATE_API@
+#cmakedefine O_VMI_PAIR_STATS @O_VMI_PAIR_STATS@
 
 #cmakedefine HAVE_PTHREAD_GETCPUCLOCKID
 #cmakedefine HAVE_F_SETLKW
@@ -1942,6 +1942,7 @@ initPrologFlags(void)
 #endif
   setPrologFlag("unload_foreign_libraries", FT_BOOL, false, 0);
   setPrologFlag("gc",	  FT_BOOL,	       true,  PLFLAG_GC);
+  setPrologFlag("gc_generational", FT_BOOL,   false, PLFLAG_GC_GENERATIONAL);
   setPrologFlag("trace_gc",  FT_BOOL,	       false, PLFLAG_TRACE_GC);
 #ifdef O_ATOMGC
   setPrologFlag("agc_margin", FT_INTEGER, (intptr_t)GD->atoms.margin);
@@ -1986,6 +1987,10 @@ initPrologFlags(void)
   setPrologFlag("engines",	FT_BOOL, true, 0);
 #endif
 #endif
+#ifdef O_ENGINES
+  setPrologFlag("shared_thread_local", FT_BOOL, true,
+		PLFLAG_SHARED_THREAD_LOCAL);
+#endif
 #ifdef O_DDE
   setPrologFlag("dde", FT_BOOL|FF_READONLY, true, 0);
 #endif
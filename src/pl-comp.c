@@ -127,6 +127,14 @@ NOTE:	If the assert() fails, look at pl-wam.c: VMI(C_NOT, ... for
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 #if VMCODE_IS_ADDRESS
+#if O_QUICKEN
+static const vmi quickened_vmi[] =	/* quickened, base */
+{ I_ENTER_Q, I_ENTER,
+  A_ENTER_Q, A_ENTER,
+  0
+};
+#endif
+
 void
 initWamTable(DECL_LD)
 { unsigned int n;
@@ -166,6 +174,10 @@ initWamTable(DECL_LD)
 		 n,		     codeTable[n].name);
     dewam_table[index] = (unsigned char) n;
   }
+#if O_QUICKEN
+  for(const vmi *q = quickened_vmi; *q; q += 2)
+    dewam_table[wam_table[q[0]]-dewam_table_offset] = (unsigned char)q[1];
+#endif
 
   checkCodeTable();
   initSupervisors();
@@ -351,6 +363,7 @@ typedef struct _varDef
 #define VD_UNBALANCED	    0x08
 #define VD_ARGUMENT	    0x10	/* Unified against an argument */
 #define VD_ARGUMENT_DONE    0x20	/* Generated unification code */
+#define VD_FLOAT	    0x40	/* Probably a float (arithmetic) */
 
 typedef struct
 { unsigned int	isize;
@@ -379,6 +392,12 @@ typedef struct merge_state
   size_t	merge_pos;		/* The merge candidate location */
 } merge_state;
 
+typedef struct hconst_state
+{ size_t	start;			/* Start of packable H_ATOM, etc. */
+  size_t	end;			/* End thereof */
+  word		value;			/* The constant */
+} hconst_state;
+
 typedef enum target_module_type
 { TM_NONE = 0,				/* No explicit target */
   TM_MODULE,				/* Explicit module target */
@@ -406,6 +425,7 @@ typedef struct
   int		progress;		/* Periodically check for interrupts */
   cutInfo	cut;			/* how to compile ! */
   merge_state	mstate;			/* Instruction merging state */
+  hconst_state	hconst;			/* Pending constant for H_CONST2 */
   VarTable	used_var;		/* boolean array of used variables */
   Buffer	branch_vars;		/* We are in a branch */
   target_module colon_context;		/* Context:Goal */
@@ -1283,7 +1303,7 @@ Variable table operations.
 #define	compileListFF(arg, ci)				LDFUNC(compileListFF, arg, ci)
 #define	compileSimpleAddition(Word, compileInfo)	LDFUNC(compileSimpleAddition, Word, compileInfo)
 #define	compileArith(Word, compileInfo)			LDFUNC(compileArith, Word, compileInfo)
-#define	compileArithArgument(Word, compileInfo)		LDFUNC(compileArithArgument, Word, compileInfo)
+#define	compileArithArgument(Word, compileInfo, flt)	LDFUNC(compileArithArgument, Word, compileInfo, flt)
 #define	compileBodyUnify(arg, ci)			LDFUNC(compileBodyUnify, arg, ci)
 #define	compileBodyEQ(arg, ci)				LDFUNC(compileBodyEQ, arg, ci)
 #define	compileBodyNEQ(arg, ci)				LDFUNC(compileBodyNEQ, arg, ci)
@@ -1293,6 +1313,7 @@ Variable table operations.
 #define	compileBodyTypeTest(functor, arg, ci)		LDFUNC(compileBodyTypeTest, functor, arg, ci)
 #define	compileBodyCallContinuation(arg, ci)		LDFUNC(compileBodyCallContinuation, arg, ci)
 #define	compileBodyShift(arg, ci, for_copy)		LDFUNC(compileBodyShift, arg, ci, for_copy)
+#define	compileInlinedCall(arg, call, ci)		LDFUNC(compileInlinedCall, arg, call, ci)
 #endif /*USE_LD_MACROS*/
 
 #define LDFUNC_DECLARATIONS
@@ -1307,7 +1328,7 @@ forwards int	compileListFF(word arg, compileInfo *ci);
 forwards bool	compileSimpleAddition(Word, compileInfo *);
 #if O_COMPILE_ARITH
 forwards int	compileArith(Word, compileInfo *);
-forwards bool	compileArithArgument(Word, compileInfo *);
+forwards bool	compileArithArgument(Word, compileInfo *, bool *);
 #endif
 #if O_COMPILE_IS
 forwards int	compileBodyUnify(Word arg, compileInfo *ci);
@@ -1321,6 +1342,7 @@ forwards int	compileBodyTypeTest(functor_t functor, Word arg,
 				    compileInfo *ci);
 forwards int	compileBodyCallContinuation(Word arg, compileInfo *ci);
 forwards int	compileBodyShift(Word arg, compileInfo *ci, int for_copy);
+forwards int	compileInlinedCall(Word arg, code call, compileInfo *ci);
 static void	initMerge(CompileInfo ci);
 static int	mergeInstructions(CompileInfo ci, const vmi_merge *m, vmi c);
 static int	try_fast_condition(CompileInfo ci, size_t tc_or);
@@ -1709,6 +1731,24 @@ mergeStep(vmi c1, vmi c2)
   addMerge(c1, &m);
 }
 
+/* Fuse c1 with c2 into op, where op takes the arguments of c1 followed
+ * by those of c2.  The implementation of op normally uses VMI_GOTO()
+ * to run c2.  Only use this for c1 and c2 that are never separated by
+ * a jump target.
+ */
+
+static void
+mergeFuse(vmi c1, vmi c2, vmi op)
+{ vmi_merge m;
+
+  memset(&m, 0, sizeof(m));
+  m.code     = c2;
+  m.how      = VMI_FUSE;
+  m.merge_op = op;
+
+  addMerge(c1, &m);
+}
+
 
 static void
 initVMIMerge(void)
@@ -1725,6 +1765,9 @@ initVMIMerge(void)
   mergeSeq(H_VOID_N, I_SSU_CHOICE, I_SSU_CHOICE, 0);
   mergeSeq(H_VOID,   H_POP,	   H_POP,	 0);
   mergeSeq(H_VOID_N, H_POP,	   H_POP,	 0);
+
+  mergeFuse(L_VAR,   I_TCALL,	   L_VAR_TCALL);
+  mergeFuse(L_VAR,   I_LCALL,	   L_VAR_LCALL);
 }
 
 
@@ -1769,6 +1812,16 @@ mergeInstructions(CompileInfo ci, const vmi_merge *m, vmi c)
 	  OpCode(ci, ci->mstate.merge_pos+1)++;
 	  return true;
 	}
+	case VMI_FUSE:
+	{ DEBUG(2,
+		Sdprintf("Fusing %s at %d with %s\n",
+			 codeTable[decode(OpCode(ci,ci->mstate.merge_pos))].name,
+			 ci->mstate.merge_pos,
+			 codeTable[c].name));
+	  OpCode(ci, ci->mstate.merge_pos) = encode(m->merge_op);
+	  ci->mstate.candidates = NULL;
+	  return true;
+	}
       }
       break;
     }
@@ -1893,7 +1946,7 @@ compileClauseGuarded(DECL_LD CompileInfo ci, Clause *cp, Word head, Word body,
 			    truePrologFlag(PLFLAG_OPTIMISE_UNIFY)
 			  )
 			);
-    clause.flags     = flags & (SSU_COMMIT_CLAUSE|SSU_CHOICE_CLAUSE);
+    clause.flags     = flags & (SSU_COMMIT_CLAUSE|SSU_CHOICE_CLAUSE|CL_INLINED);
   } else
   { Word g = varFrameP(lTop, VAROFFSET(1));
 
@@ -1947,6 +2000,7 @@ compileClauseGuarded(DECL_LD CompileInfo ci, Clause *cp, Word head, Word body,
     ci->used_var = NULL;
 
   initMerge(ci);
+  ci->hconst.end = (size_t)-1;
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 First compile  the  head  of  the  term.   The  arguments  are  compiled
@@ -2067,6 +2121,7 @@ Finish up the clause.
     ATOMIC_ADD(&m->code_size, clsize);
     memcpy(cl, &clause, sizeofClause(0));
     memcpy(cl->codes, baseBuffer(&ci->codes, code), sizeOfBuffer(&ci->codes));
+    setClauseGuard(cl);
 
     ATOMIC_ADD(&GD->statistics.codes, clause.code_size);
     ATOMIC_INC(&GD->statistics.clauses);
@@ -2487,6 +2542,8 @@ right_argument:
 #endif /*O_CALL_AT_MODULE*/
       }
       assert(0);
+    } else if ( fd == FUNCTOR_dinline3 && ison(ci->clause, CL_INLINED) )
+    { return compileInlinedCall(body, call, ci);
     }
   }
 
@@ -2533,6 +2590,10 @@ try_fast_condition(CompileInfo ci, size_t tc_or)
       case A_FUNC:
       case A_ADD:
       case A_MUL:
+      case A_FADD:
+      case A_FSUB:
+      case A_FMUL:
+      case A_FDIV:
       case A_LT:
       case A_LE:
       case A_GT:
@@ -2592,6 +2653,45 @@ link_local_var(DECL_LD Word v, int iv, CompileInfo ci)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+output_head_const() emits a constant that is an argument of the head. If
+the previous instruction is a  constant  for   the  previous  argument and
+both fit in 32 bits, both are combined into a single H_CONST2.
+
+@return false if `c` does not fit in 32 bits.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static bool
+output_head_const(compileInfo *ci, word c)
+{
+#ifdef O_CONST2
+  if ( isConst32(c) )
+  { size_t pc = PC(ci);
+
+    if ( ci->hconst.end == pc )
+    { seekBuffer(&ci->codes, ci->hconst.start, code);
+      Output_1(ci, H_CONST2, consts2code(ci->hconst.value, c));
+      ci->hconst.end = (size_t)-1;
+    } else
+    { ci->hconst.start = pc;
+      ci->hconst.value = c;
+      if ( isNil(c) )
+	Output_0(ci, H_NIL);
+      else if ( isAtom(c) )
+	Output_1(ci, H_ATOM, word2code(c));
+      else
+	Output_1(ci, H_SMALLINT, (scode)valInt(c));
+      ci->hconst.end = PC(ci);
+    }
+
+    return true;
+  }
+#endif
+
+  return false;
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Compile argument to a goal in the   clause. The `islocal' compilation is
 one of the complicating factors: atoms   should not be registered (there
@@ -2633,6 +2733,8 @@ A void.  Generate either B_VOID or H_VOID.
       if ( storage(*arg) == STG_INLINE )
       { sword i = valInt(*arg);
 
+	if ( where == A_HEAD && output_head_const(ci, *arg) )
+	  return true;
 #if CODES_PER_WORD == 1
 	Output_1(ci, (where & A_BODY) ? B_SMALLINT : H_SMALLINT, (scode)i);
 #else
@@ -2655,11 +2757,13 @@ A void.  Generate either B_VOID or H_VOID.
       return true;
     case TAG_ATOM:
       if ( isNil(*arg) )
-      {	Output_0(ci, (where & A_BODY) ? B_NIL : H_NIL);
+      {	if ( !(where == A_HEAD && output_head_const(ci, *arg)) )
+	  Output_0(ci, (where & A_BODY) ? B_NIL : H_NIL);
       } else
       { if ( !ci->islocal )
 	  PL_register_atom(word2atom(*arg));
-	Output_1(ci, (where & A_BODY) ? B_ATOM : H_ATOM, word2code(*arg));
+	if ( !(where == A_HEAD && output_head_const(ci, *arg)) )
+	  Output_1(ci, (where & A_BODY) ? B_ATOM : H_ATOM, word2code(*arg));
       }
       return true;
     case TAG_FLOAT:
@@ -3171,6 +3275,67 @@ appropriate calling instruction.
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Compile '$inline'(Goal, Gen, Inlined), created by inline_body() for calls
+to small static predicates. This creates
+
+	C_INLINE <jmp> <proc> <gen> <Inlined> C_JMP <n> <Goal>
+
+The two branches are balanced as for (Inlined ; Goal). The decompiler,
+GC and source-level debugger skip <Inlined>, so the clause is seen as
+calling Goal. See C_INLINE in pl-vmi.c for when the inlined code is
+used.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+compileInlinedCall(DECL_LD Word arg, code call, compileInfo *ci)
+{ Word goal    = argTermP(*arg, 0);
+  Word gen     = argTermP(*arg, 1);
+  Word inlined = argTermP(*arg, 2);
+  VarTable vsave, valt1, valt2;
+  Procedure proc;
+  size_t tc_inline, tc_jmp;
+  int rv;
+
+  deRef(goal);
+  deRef(gen);
+  if ( !isTaggedInt(*gen) || !isTerm(*goal) ||
+       ci->colon_context.type != TM_NONE
+#ifdef O_CALL_AT_MODULE
+       || ci->at_context.type != TM_NONE
+#endif
+     )
+    return compileBody(goal, call, ci);
+
+  proc = lookupBodyProcedure(functorTerm(*goal), ci->module);
+
+  vsave = mkCopiedVarTable(ci->used_var);
+  valt1 = mkCopiedVarTable(ci->used_var);
+  valt2 = mkCopiedVarTable(ci->used_var);
+  setVars(inlined, valt1);
+  setVars(goal, valt2);
+
+  Output_3(ci, C_INLINE, (code)0, ptr2code(proc), (code)valInt(*gen));
+  tc_inline = PC(ci);
+  if ( (rv=compileBody(inlined, I_CALL, ci)) != true )
+    return rv;
+  balanceVars(valt1, valt2, ci);
+  Output_1(ci, C_JMP, (code)0);
+  tc_jmp = PC(ci);
+  OpCode(ci, tc_inline-3) = (code)(PC(ci) - tc_inline);
+  copyVarTable(ci->used_var, vsave);
+  if ( (rv=compileBody(goal, call, ci)) != true )
+    return rv;
+  balanceVars(valt2, valt1, ci);
+  OpCode(ci, tc_jmp-1) = (code)(PC(ci) - tc_jmp);
+
+  orVars(valt1, valt2);
+  copyVarTable(ci->used_var, valt1);
+
+  return true;
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 compileSimpleAddition() compiles NewVar is Var   +/- SmallInt. At entry,
 vc is known to be a dereferenced pointer to term is/2.  For addition, it
@@ -3234,8 +3399,18 @@ I_DEPART <proc>
 
 This code analyses  the code that sets up the  arguments to <proc> and
 emits code  to deal  with the  LCO case, ending  either in  I_TCALL or
-I_LCALL <proc>.  Finally, we swap the LCO and non-LCO code using three
+I_LCALL <proc>.  If the last instruction  of the LCO case is an L_VAR,
+it is fused  with these into L_VAR_TCALL  or L_VAR_LCALL (see
+initVMIMerge()).  Finally, we swap the LCO and non-LCO code using three
 calls to reverse_code().
+
+The argument slots of the frame act as the register file of the call.
+Moving variables into them is a parallel move: a slot may only be
+overwritten after all moves that read it are done.  We emit the moves
+in such an order and break cycles (e.g., p(A,B) :- p(B,A)) by saving
+one slot in a fresh frame variable.  This variable is reset using C_VAR
+at the start of the non-LCO code such that clearUninitialisedVarsFrame()
+sees it.  Constants are written last, as they do not read any slot.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 static void
@@ -3249,6 +3424,23 @@ reverse_code(Code a, Code z)
   }
 }
 
+#define LCO_CONST	(-1)		/* argument is not a variable */
+#define LCO_DONE	(-2)		/* argument is in place */
+
+typedef struct lco_arg
+{ int		src;			/* source variable or LCO_* */
+  size_t	at;			/* offset of B_* instruction */
+} lco_arg;
+
+static bool
+lco_is_source(const lco_arg *args, size_t argc, int var)
+{ for(size_t i=0; i<argc; i++)
+  { if ( args[i].src == var )
+      return true;
+  }
+
+  return false;
+}
 
 static void
 lco(CompileInfo ci, size_t pc0)
@@ -3257,7 +3449,12 @@ lco(CompileInfo ci, size_t pc0)
   Code s0    = base+pc0;
   Code s     = s0;
   Code e     = base+pcz;
-  int oarg   = 0;
+  Procedure depart_proc = code2ptr(Procedure, e[-1]);
+  size_t argc = depart_proc->definition->functor->arity;
+  lco_arg *args = alloca((argc+1)*sizeof(*args));
+  size_t oarg = 0;
+  int moves = 0;
+  int tmp = 0;
   Code z;
 
 #define FIX_BUFFER_SHIFT() \
@@ -3272,53 +3469,92 @@ lco(CompileInfo ci, size_t pc0)
 	} while(0)
 
   assert(decode(e[-2]) == I_DEPART);
-  Output_1(ci, L_NOLCO, (code)0);
-  FIX_BUFFER_SHIFT();
 
   for(; s < e-2; oarg++ )
-  { code c = decode(*s++);
-    const code_info *vmi = &codeTable[c];
+  { code c = decode(*s);
     int bv;
 
-    if ( isoff(vmi, VIF_LCO) )
-    { no_lco:
-      seekBuffer(&(ci)->codes, pcz, code);
+    if ( isoff(&codeTable[c], VIF_LCO) || oarg >= argc )
       return;
-    }
 
     switch(c)
-    { case B_VAR0: bv = 0; goto common_bv;
-      case B_VAR1: bv = 1; goto common_bv;
-      case B_VAR2: bv = 2; goto common_bv;
-      case B_VAR:
-      { bv = VARNUM(*s++);
-      common_bv:
-	if ( bv < oarg )		/* would overwrite */
-	  goto no_lco;
-	if ( bv != oarg )
-	{ Output_2(ci, L_VAR, VAROFFSET(oarg), VAROFFSET(bv));
-	}
-	break;
+    { case B_VAR0: bv = 0; break;
+      case B_VAR1: bv = 1; break;
+      case B_VAR2: bv = 2; break;
+      case B_VAR:  bv = VARNUM(s[1]); break;
+      default:     bv = LCO_CONST; break;
+    }
+    if ( bv == (int)oarg )
+      bv = LCO_DONE;
+    else if ( bv >= 0 )
+      moves++;
+
+    args[oarg].src = bv;
+    args[oarg].at  = s-base;
+    s = stepPC(s);
+  }
+  assert(oarg == argc);
+
+  Output_1(ci, L_NOLCO, (code)0);
+  FIX_BUFFER_SHIFT();
+
+  while( moves > 0 )
+  { bool progress = false;
+
+    for(size_t i=0; i<argc; i++)
+    { if ( args[i].src >= 0 && !lco_is_source(args, argc, (int)i) )
+      { Output_2(ci, L_VAR, VAROFFSET(i), VAROFFSET(args[i].src));
+	args[i].src = LCO_DONE;
+	moves--;
+	progress = true;
       }
-      case B_VOID:
+    }
+
+    if ( !progress )			/* only cycles left */
+    { size_t i;
+
+      for(i=0; args[i].src < 0; i++)
+	;
+      if ( !tmp &&			/* tmp may not be a target */
+	   ( ci->clause->variables < argc ||
+	     !(tmp = allocChoiceVar(ci)) ) )
+      { seekBuffer(&(ci)->codes, pcz, code);
+	return;
+      }
+      Output_2(ci, L_VAR, tmp, VAROFFSET(i));
+      for(size_t j=0; j<argc; j++)
+      { if ( args[j].src == (int)i )
+	  args[j].src = VARNUM(tmp);
+      }
+    }
+    FIX_BUFFER_SHIFT();
+  }
+
+  for(oarg=0; oarg<argc; oarg++)
+  { if ( args[oarg].src != LCO_CONST )
+      continue;
+
+    s = base+args[oarg].at;
+    switch(decode(*s++))
+    { case B_VOID:
 	Output_1(ci, L_VOID, VAROFFSET(oarg));
 	break;
       case B_SMALLINT:
-      { code a = *s++;
+      { code a = *s;
 	Output_2(ci, L_SMALLINT, VAROFFSET(oarg), a);
 	break;
       }
 #if CODES_PER_WORD > 1
       case B_SMALLINTW:
       { word a;
-	s = code_get_word(s, &a);
+	code_get_word(s, &a);
 	Output_1(ci, L_SMALLINTW, VAROFFSET(oarg));
 	Output_an(ci, &a, CODES_PER_WORD);
 	break;
       }
 #endif
       case B_ATOM:
-      { code a = *s++;
+      { code a = *s;
 	PL_register_atom(a);		/* TBD: unregister on failure */
 	Output_2(ci, L_ATOM, VAROFFSET(oarg), a);
 	break;
@@ -3333,8 +3569,6 @@ lco(CompileInfo ci, size_t pc0)
     FIX_BUFFER_SHIFT();
   }
 
-  Procedure depart_proc = code2ptr(Procedure, e[-1]);
-
   if ( ci->procedure ==	depart_proc )
     Output_0(ci, I_TCALL);
   else
@@ -3344,6 +3578,11 @@ lco(CompileInfo ci, size_t pc0)
 
   z = topBuffer(&(ci)->codes, code);
   e[1] = (code)(z-e-2);			/* fill L_NOLCO argument */
+  if ( tmp )				/* initialise for the GC and debugger */
+  { Output_1(ci, C_VAR, tmp);		/* on the non-LCO path */
+    FIX_BUFFER_SHIFT();
+    z = topBuffer(&(ci)->codes, code);
+  }
 
   reverse_code(s0, e);
   reverse_code(e,  z);
@@ -3387,6 +3626,7 @@ static int
 compileArith(DECL_LD Word arg, compileInfo *ci)
 { code a_func;
   functor_t fdef = functorTerm(*arg);
+  bool flt;
 
   if      ( fdef == FUNCTOR_ar_equals2 )	a_func = A_EQ;	/* =:= */
   else if ( fdef == FUNCTOR_ar_not_equal2 )	a_func = A_NE;	/* =\= */
@@ -3398,6 +3638,7 @@ compileArith(DECL_LD Word arg, compileInfo *ci)
   { size_t tc_a1 = PC(ci);
     code isvar;
     bool rc;
+    Word r;
 
     rc=compileArgument(argTermP(*arg, 0), A_BODY, ci);
     if ( rc != true )
@@ -3408,9 +3649,13 @@ compileArith(DECL_LD Word arg, compileInfo *ci)
     } else
       isvar = 0;
     Output_0(ci, A_ENTER);
-    rc = compileArithArgument(argTermP(*arg, 1), ci);
+    rc = compileArithArgument(argTermP(*arg, 1), ci, &flt);
     if ( rc != true )
       return rc;
+    r = argTermP(*arg, 0);
+    deRef(r);
+    if ( flt && isVarInfo(*r) )
+      set(varInfo(*r), VD_FLOAT);
     if ( isvar )
       Output_1(ci, A_FIRSTVAR_IS, isvar);
     else
@@ -3422,8 +3667,8 @@ compileArith(DECL_LD Word arg, compileInfo *ci)
   }
 
   Output_0(ci, A_ENTER);
-  if ( !compileArithArgument(argTermP(*arg, 0), ci) ||
-       !compileArithArgument(argTermP(*arg, 1), ci) )
+  if ( !compileArithArgument(argTermP(*arg, 0), ci, &flt) ||
+       !compileArithArgument(argTermP(*arg, 1), ci, &flt) )
     fail;
 
   Output_0(ci, a_func);
@@ -3464,11 +3709,17 @@ arithVarOffset(DECL_LD Word arg, compileInfo *ci, int *offp)
 }
 
 
+/* compileArithArgument() compiles an arithmetic expression.  If `flt`
+ * is set to true, the result is probably a float.  This is used to emit
+ * A_FADD, etc.
+ */
+
 static bool
-compileArithArgument(DECL_LD Word arg, compileInfo *ci)
+compileArithArgument(DECL_LD Word arg, compileInfo *ci, bool *flt)
 { int index;
   int rc;
 
+  *flt = false;
   deRef(arg);
 
   if ( isRational(*arg) )
@@ -3494,11 +3745,13 @@ compileArithArgument(DECL_LD Word arg, compileInfo *ci)
   { Word p = valIndirectP(*arg);
 
     Output_n(ci, A_DOUBLE, p, CODES_PER_DOUBLE);
+    *flt = true;
     succeed;
   }
 
   if ( (rc=arithVarOffset(arg, ci, &index)) == true )
-  { if ( index < 3 )
+  { *flt = ison(varInfo(*arg), VD_FLOAT);
+    if ( index < 3 )
       Output_0(ci, A_VAR0 + index);
     else
       Output_1(ci, A_VAR, VAROFFSET(index));
@@ -3512,6 +3765,7 @@ compileArithArgument(DECL_LD Word arg, compileInfo *ci)
   { functor_t fdef;
     size_t n, ar;
     Word a;
+    bool aflt = false;
 
     if ( isTextAtom(*arg) )
     { fdef = lookupFunctorDef(word2functor(*arg), 0);
@@ -3567,22 +3821,40 @@ compileArithArgument(DECL_LD Word arg, compileInfo *ci)
 	return false;
       }
 
-      compileArithArgument(a, ci);
+      compileArithArgument(a, ci, &aflt);
+      aflt = false;
     } else
     { for(a+=ar-1, n=ar; n-- > 0; a--)	/* pushed right to left */
-      { if ( !compileArithArgument(a, ci) )
+      { bool f;
+
+	if ( !compileArithArgument(a, ci, &f) )
 	  return false;
+	aflt |= f;
       }
     }
 
     if ( fdef == FUNCTOR_plus2 )
-    { Output_0(ci, A_ADD);
+    { Output_0(ci, aflt ? A_FADD : A_ADD);
+      *flt = aflt;
       succeed;
     }
     if ( fdef == FUNCTOR_star2 )
-    { Output_0(ci, A_MUL);
+    { Output_0(ci, aflt ? A_FMUL : A_MUL);
+      *flt = aflt;
+      succeed;
+    }
+    if ( aflt && fdef == FUNCTOR_minus2 )
+    { Output_1(ci, A_FSUB, index);
+      *flt = true;
       succeed;
     }
+    if ( aflt && fdef == FUNCTOR_divide2 )
+    { Output_1(ci, A_FDIV, index);
+      *flt = true;
+      succeed;
+    }
+    if ( fdef == FUNCTOR_float1 )
+      *flt = true;
 
     switch(ar)
     { case 0:	Output_1(ci, A_FUNC0, index); break;
@@ -4070,6 +4342,8 @@ compileTypeTest(DECL_LD Word arg,
       return rc;
     }
 
+    if ( instruction == I_FLOAT )	/* see compileArithArgument() */
+      set(varInfo(*a1), VD_FLOAT);
     Output_1(ci, instruction, VAROFFSET(i1));
     return true;
   }
@@ -4209,6 +4483,17 @@ forAtomsInCodes(size_t size, Code PC, int (func)(atom_t a, void*), void *ctx)
 	  return false;
 	break;
       }
+#ifdef O_CONST2
+      case H_CONST2:
+      { for(int i=0; i<2; i++)
+	{ word w = code2const(PC[1], i);
+
+	  if ( isAtom(w) && !isNil(w) && !(*func)(word2atom(w), ctx) )
+	    return false;
+	}
+	break;
+      }
+#endif
       case B_EQ_VC:
       case B_UNIFY_FC:
       case B_UNIFY_VC:			/* var, const */
@@ -4283,6 +4568,353 @@ prevPC(const Clause clause, const Code pc)
 }
 
 
+		 /*******************************
+		 *	       INLINING		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+If the Prolog flag `optimise` is true, inline_body() replaces calls from
+a  clause  that  is  loaded from  a  file  to small  static  predicates
+consisting of a single clause that   only does unification and tests by
+'$inline'(Goal, Gen, Inlined). Inlined is the   conjunction  of the head
+unifications and the body of the  clause.   Gen  is  the last modified
+generation of the callee. See  compileInlinedCall()   and  C_INLINE for
+the compiled result.  Calls to call/N  with   a  known closure are also
+turned into '$inline'/3 terms (see fold_metacall()).
+
+The body of the callee may only  call the predicates in inline_tests[]
+and these must not be redefined  in  the   module  of  the caller or the
+callee.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define INLINE_MAX_CODES 48		/* Max code size of inlined clause */
+#define INLINE_MAX_DEPTH 500		/* Max nesting of the body */
+
+#define INLINE_NO_DEF_FLAGS \
+	(P_DYNAMIC|P_THREAD_LOCAL|P_FOREIGN|P_TRANSPARENT|P_META| \
+	 P_MULTIFILE|P_LOCKED|P_LOCKED_SUPERVISOR|P_DET|P_SSU_DET| \
+	 P_NOPROFILE|SPY_ME)
+
+static const functor_t inline_tests[] =
+{ FUNCTOR_equals2,
+  FUNCTOR_strict_equal2,
+  FUNCTOR_not_strict_equal2,
+  FUNCTOR_var1,
+  FUNCTOR_nonvar1,
+  FUNCTOR_integer1,
+  FUNCTOR_float1,
+  FUNCTOR_number1,
+  FUNCTOR_atomic1,
+  FUNCTOR_atom1,
+  FUNCTOR_string1,
+  FUNCTOR_compound1,
+  FUNCTOR_callable1,
+  FUNCTOR_is2,
+  FUNCTOR_smaller2,
+  FUNCTOR_larger2,
+  FUNCTOR_smaller_equal2,
+  FUNCTOR_larger_equal2,
+  FUNCTOR_ar_equals2,
+  FUNCTOR_ar_not_equal2,
+  (functor_t)0
+};
+
+#define is_inline_test(f, m) LDFUNC(is_inline_test, f, m)
+static bool
+is_inline_test(DECL_LD functor_t f, Module m)
+{ const functor_t *tp;
+  Procedure proc;
+
+  for(tp = inline_tests; *tp; tp++)
+  { if ( *tp == f )
+      break;
+  }
+  if ( !*tp )
+    return false;
+
+  if ( m != MODULE_system &&
+       (proc=isCurrentProcedure(f, m)) &&
+       isDefinedProcedure(proc) )
+    return false;			/* redefined */
+
+  return true;
+}
+
+
+#define inlinable_body(body, m1, m2) LDFUNC(inlinable_body, body, m1, m2)
+static bool
+inlinable_body(DECL_LD term_t body, Module m1, Module m2)
+{ functor_t f;
+  atom_t a;
+
+  if ( PL_get_atom(body, &a) )
+    return a == ATOM_true;
+  if ( !PL_get_functor(body, &f) )
+    return false;
+
+  if ( f == FUNCTOR_comma2 )
+  { term_t arg = PL_new_term_ref();
+    bool rc;
+
+    rc = ( _PL_get_arg(1, body, arg), inlinable_body(arg, m1, m2) &&
+	   (_PL_get_arg(2, body, arg), inlinable_body(arg, m1, m2)) );
+    PL_reset_term_refs(arg);
+
+    return rc;
+  }
+
+  return is_inline_test(f, m1) && is_inline_test(f, m2);
+}
+
+
+/* Prepend the unification of the first `arity` arguments of `t1` and
+ * `t2` to the conjunction `conj`.  If both sides are nonvar we unify
+ * their arguments or replace the conjunction by `fail` as =/2 between
+ * two nonvar terms is not compiled inline.
+ */
+
+#define prepend_unify_args(t1, t2, arity, conj) \
+	LDFUNC(prepend_unify_args, t1, t2, arity, conj)
+
+static bool
+prepend_unify_args(DECL_LD term_t t1, term_t t2, size_t arity, term_t conj)
+{ for(size_t i=arity; i > 0; i--)
+  { term_t a  = PL_new_term_refs(3);
+    term_t h  = a+1;
+    term_t eq = a+2;
+    functor_t fa, fh;
+    atom_t ca;
+
+    _PL_get_arg(i, t1, a);
+    _PL_get_arg(i, t2, h);
+    if ( PL_is_variable(a) || PL_is_variable(h) )
+    { if ( !PL_cons_functor(eq, FUNCTOR_equals2, a, h) )
+	return false;
+      if ( PL_get_atom(conj, &ca) && ca == ATOM_true )
+	PL_put_term(conj, eq);
+      else if ( !PL_cons_functor(conj, FUNCTOR_comma2, eq, conj) )
+	return false;
+    } else if ( PL_get_functor(a, &fa) && PL_is_compound(a) &&
+		PL_get_functor(h, &fh) && PL_is_compound(h) )
+    { if ( fa != fh )
+	PL_put_atom(conj, ATOM_fail);
+      else if ( !prepend_unify_args(a, h, arityFunctor(fa), conj) )
+	return false;
+    } else if ( PL_is_compound(a) || PL_is_compound(h) ||
+		PL_compare(a, h) != 0 )
+    { PL_put_atom(conj, ATOM_fail);
+    }
+    PL_reset_term_refs(a);
+  }
+
+  return true;
+}
+
+
+/* Returns true if the clause  for   `goal`  can  be inlined, filling
+ * `inlined` with the '$inline'/3 term, false if  it cannot be inlined
+ * or -1 on an error.
+ */
+
+#define inline_goal(goal, m, caller, inlined) \
+	LDFUNC(inline_goal, goal, m, caller, inlined)
+
+static int
+inline_goal(DECL_LD term_t goal, Module m, Definition caller, term_t inlined)
+{ functor_t fd;
+  Procedure proc;
+  Definition def;
+  definition_ref *dref;
+  ClauseRef cref;
+  Clause cl = NULL;
+  gen_t gen;
+  term_t t, h, b, g;
+  size_t arity;
+
+  if ( !PL_get_functor(goal, &fd) ||
+       (arity=arityFunctor(fd)) == 0 ||
+       ison(valueFunctor(fd), CONTROL_F) ||
+       !(proc=isCurrentProcedure(fd, m)) ||
+       !isDefinedProcedure(proc) )
+    return false;
+
+  def = proc->definition;
+  if ( def == caller ||
+       def->module == MODULE_system ||
+       ison(def, INLINE_NO_DEF_FLAGS) ||
+       def->tabling ||
+       !def->impl.clauses.first_clause ||
+       def->codes[0] == encode(S_CALLWRAPPER) )
+    return false;
+  gen = def->last_modified;
+  if ( gen == GEN_INVALID || gen >= GEN_TRANSACTION_BASE )
+    return false;
+
+  if ( !(dref=pushPredicateAccessObj(def)) )
+    return -1;
+  for(cref = def->impl.clauses.first_clause; cref; cref = cref->next)
+  { Clause c = cref->value.clause;
+
+    if ( visibleClause(c, dref->generation) )
+    { if ( cl )
+      { cl = NULL;			/* more than one clause */
+	break;
+      }
+      cl = c;
+    }
+  }
+  if ( cl &&
+       ( cl->code_size > INLINE_MAX_CODES ||
+	 ison(cl, CLAUSE_SSU_FLAGS|CL_BODY_CONTEXT) ) )
+    cl = NULL;
+
+  t = PL_new_term_ref();
+  if ( cl && !decompile(cl, t, 0) )
+  { popPredicateAccess(def);
+    return -1;
+  }
+  popPredicateAccess(def);
+  if ( !cl || def->last_modified != gen )
+    return false;
+
+  if ( !(h=PL_new_term_refs(3)) )
+    return -1;
+  b = h+1;
+  g = h+2;
+  if ( PL_is_functor(t, FUNCTOR_prove2) )
+  { _PL_get_arg(1, t, h);
+    _PL_get_arg(2, t, b);
+    if ( !inlinable_body(b, m, def->module) )
+      return false;
+  } else
+  { PL_put_term(h, t);
+    PL_put_atom(b, ATOM_true);
+  }
+
+					/* Inlined is A1=H1, ..., An=Hn, Body */
+  if ( !prepend_unify_args(goal, h, arity, b) )
+    return -1;
+
+  if ( !PL_put_int64(g, gen) ||
+       !PL_cons_functor(inlined, FUNCTOR_dinline3, goal, g, b) )
+    return -1;
+
+  return true;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+fold_metacall() handles call(Closure, A1, ...) where Closure is known at
+compile time, i.e., is an atom or compound  that does not turn into a
+control structure.  `folded` is  '$inline'(Goal, INLINE_GEN_ANY, Call),
+where Call is  Closure  extended  with   A1,  ...   This  replaces  the
+meta-call (I_CALL1 or I_CALLN) by a  normal   call  while  listing and the
+debugger still see Goal.  Calls from transparent predicates are not
+folded as these are resolved in the context module at runtime.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define fold_metacall(goal, caller, folded) \
+	LDFUNC(fold_metacall, goal, caller, folded)
+
+static int
+fold_metacall(DECL_LD term_t goal, Definition caller, term_t folded)
+{ functor_t fd, fc, fg;
+  size_t extra, carity, arity;
+  term_t av, g;
+
+  if ( !PL_get_functor(goal, &fd) ||
+       nameFunctor(fd) != ATOM_call ||
+       ison(caller, P_TRANSPARENT) )
+    return false;
+
+  extra = arityFunctor(fd)-1;
+  if ( !(av=PL_new_term_ref()) )
+    return -1;
+  _PL_get_arg(1, goal, av);
+  if ( !PL_is_callable(av) || !PL_get_functor(av, &fc) ||
+       ison(valueFunctor(fc), CONTROL_F) )
+    return false;
+  carity = arityFunctor(fc);
+  arity  = carity+extra;
+  if ( arity == 0 || arity > MAXARITY )
+    return false;
+  fg = PL_new_functor(nameFunctor(fc), arity);
+  if ( ison(valueFunctor(fg), CONTROL_F) )
+    return false;
+
+  if ( !(g=PL_new_term_ref()) ||
+       !(av=PL_new_term_refs(arity)) )
+    return -1;
+  _PL_get_arg(1, goal, g);
+  for(size_t i=0; i<carity; i++)
+    _PL_get_arg(i+1, g, av+i);
+  for(size_t i=0; i<extra; i++)
+    _PL_get_arg(i+2, goal, av+carity+i);
+
+  if ( !PL_cons_functor_v(g, fg, av) ||
+       !PL_put_int64(av, (int64_t)(scode)INLINE_GEN_ANY) ||
+       !PL_cons_functor(folded, FUNCTOR_dinline3, goal, av, g) )
+    return -1;
+
+  return true;
+}
+
+
+/* Returns true if some goal of `body` was inlined, false if not and -1
+ * on an error.  If true, `body` refers to the new body.
+ */
+
+#define inline_body(body, m, caller, depth) \
+	LDFUNC(inline_body, body, m, caller, depth)
+
+static int
+inline_body(DECL_LD term_t body, Module m, Definition caller, int depth)
+{ functor_t fd;
+  FunctorDef fdef;
+
+  if ( ++depth > INLINE_MAX_DEPTH || !PL_get_functor(body, &fd) )
+    return false;
+  fdef = valueFunctor(fd);
+
+  if ( ison(fdef, CONTROL_F) )
+  { term_t av;
+    int rc = false;
+
+    if ( fd == FUNCTOR_colon2
+#ifdef O_CALL_AT_MODULE
+	 || fd == FUNCTOR_at_sign2
+#endif
+       )
+      return false;
+
+    if ( !(av=PL_new_term_refs((int)fdef->arity)) )
+      return -1;
+    for(size_t i=0; i<fdef->arity; i++)
+    { int rc1;
+
+      _PL_get_arg(i+1, body, av+i);
+      if ( (rc1=inline_body(av+i, m, caller, depth)) < 0 )
+	return rc1;
+      rc = rc || rc1;
+    }
+    if ( rc && !PL_cons_functor_v(body, fd, av) )
+      return -1;
+
+    return rc;
+  } else
+  { term_t inlined = PL_new_term_ref();
+    int rc;
+
+    if ( (rc=fold_metacall(body, caller, inlined)) == false )
+      rc = inline_goal(body, m, caller, inlined);
+    if ( rc == true )
+      PL_put_term(body, inlined);
+
+    return rc;
+  }
+}
+
+
 		/********************************
 		*  PROLOG DATA BASE MANAGEMENT  *
 		*********************************/
@@ -4363,6 +4995,15 @@ assert_term(DECL_LD term_t term, Module module, ClauseRef where,
   }
 #endif /*O_PROLOG_HOOK*/
 
+  if ( loc && truePrologFlag(PLFLAG_OPTIMISE) )
+  { int rc = inline_body(body, module, proc->definition, 0);
+
+    if ( rc < 0 )
+      return NULL;
+    if ( rc )
+      hflags |= CL_INLINED;
+  }
+
   DEBUG(2,
 	Sdprintf("compiling ");
 	PL_write_term(Serror, term, 1200, PL_WRT_QUOTED);
@@ -4740,11 +5381,14 @@ PRED_IMPL("compile_predicates",  1, compile_predicates, PL_FA_TRANSPARENT)
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 skipArgs() skips  arguments. When  used inside  a clause-head  and the
-skip is into the middle of a  H_VOID_N, it returns the location of the
-H_VOID_N.
+skip is into the middle of a  H_VOID_N or H_CONST2, it returns the
+location of this instruction.
 
 @param in_hvoid must initially  be set to a pointer to  0.  It is used
-to skip H_VOID_N in small steps.
+to skip H_VOID_N and H_CONST2 in small steps.  If non-zero, it is the
+number of arguments of the instruction at the returned location that
+are not skipped.  Thus, H_CONST2 with *in_hvoid == 1 refers to its
+second constant.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 Code
@@ -4753,14 +5397,15 @@ skipArgs(Code PC, int skip, int *in_hvoid)
   Code nextPC;
 
   if ( *in_hvoid )
-  { assert(*PC == encode(H_VOID_N));
-    if ( skip > *in_hvoid )
+  { assert(*PC == encode(H_VOID_N) || *PC == encode(H_CONST2));
+    if ( skip >= *in_hvoid )
     { skip -= *in_hvoid;
       *in_hvoid = 0;
+      PC = stepPC(PC);
+      if ( skip == 0 )
+	return PC;
     } else
     { (*in_hvoid) -= skip;
-      if ( *in_hvoid == 0 )
-	return stepPC(PC);
       return PC;
     }
   }
@@ -4825,13 +5470,16 @@ skipArgs(Code PC, int skip, int *in_hvoid)
 	  return nextPC;
 	continue;
       case H_VOID_N:
+      case H_CONST2:
 	if ( nested )
 	  continue;
-	skip -= (int)PC[1];
-	if ( skip <= 0 )
+	skip -= (c == H_VOID_N ? (int)PC[1] : 2);
+	if ( skip < 0 )
 	{ *in_hvoid = -skip;
 	  return PC;
 	}
+	if ( skip == 0 )
+	  return nextPC;
 	continue;
       case I_EXITFACT:
       case I_EXIT:
@@ -4869,12 +5517,21 @@ pl-index.c.
 
 bool
 argKey(Code PC, int skip, word *key)
-{ if ( skip > 0 )
-  { int h_void = 0;
+{ int h_void = 0;
+
+  if ( skip > 0 )
     PC = skipArgs(PC, skip, &h_void);
-  }
 
-  for(;;)
+  return argKeyAt(PC, h_void, key);
+}
+
+/* As argKey(), using the  location  and   `in_hvoid`  as  returned  by
+ * skipArgs().
+ */
+
+bool
+argKeyAt(Code PC, int in_hvoid, word *key)
+{ for(;;)
   { code c = decode(*PC++);
 
 #if O_DEBUGGER
@@ -4904,6 +5561,11 @@ argKey(Code PC, int skip, word *key)
       case H_NIL:
 	*key = ATOM_nil;
 	return true;
+#ifdef O_CONST2
+      case H_CONST2:
+	*key = code2const(*PC, in_hvoid ? 1 : 0);
+	return true;
+#endif
       case H_LIST_FF:
       case H_LIST:
       case H_RLIST:
@@ -4962,13 +5624,13 @@ argKey(Code PC, int skip, word *key)
 
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-Similar to argKey(), but does not do   imprecise  keys and only does the
-first argument. This is used  by   listSupervisor().  This used to share
-with argKey(), but argKey() is time critical and merging complicates it.
+Similar to argKeyAt(), but does not do imprecise keys. This is used by
+listSupervisor().  This used to share  with   argKey(),  but argKey() is
+time critical and merging complicates it.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 bool
-arg1Key(Code PC, word *key)
+arg1Key(Code PC, int in_hvoid, word *key)
 { for(;;)
   { code c = decode(*PC++);
 
@@ -4999,6 +5661,11 @@ arg1Key(Code PC, word *key)
       case H_NIL:
 	*key = ATOM_nil;
 	return true;
+#ifdef O_CONST2
+      case H_CONST2:
+	*key = code2const(*PC, in_hvoid ? 1 : 0);
+	return true;
+#endif
       case H_LIST_FF:
       case H_LIST:
       case H_RLIST:
@@ -5333,6 +6000,7 @@ decompile_head(DECL_LD Clause clause, term_t head, decompileInfo *di)
   int argn = 0;
   int pushed = 0;
   int write_bvar = false;
+  int in_const2 = false;
   Definition def = clause->predicate;
 
   if ( di->bindings )
@@ -5390,7 +6058,12 @@ decompile_head(DECL_LD Clause clause, term_t head, decompileInfo *di)
     PC++;				/* see the same arg twice */
 
   for(;;)
-  { code c = decode(*PC++);
+  { code c;
+
+    if ( in_const2 )			/* second constant of H_CONST2 */
+      c = H_CONST2;
+    else
+      c = decode(*PC++);
 
 #if O_DEBUGGER
   again:
@@ -5471,6 +6144,14 @@ decompile_head(DECL_LD Clause clause, term_t head, decompileInfo *di)
 	  TRY(PL_unify_atomic(argp, consInt((sword)w)));
 	  break;
 	}
+#ifdef O_CONST2
+      case H_CONST2:
+	  TRY(PL_unify_atomic(argp, code2const(*PC, in_const2)));
+	  if ( in_const2 )
+	    PC++;
+	  in_const2 = !in_const2;
+	  break;
+#endif
       case H_FIRSTVAR:
       case H_VAR:
 	  TRY(unifyVarGC(valTermRef(argp), di->variables,
@@ -6072,14 +6753,18 @@ decompileBodyNoShift(DECL_LD decompileInfo *di, code end, Code until)
 #endif
 #if O_COMPILE_ARITH
       case A_ADD:
+      case A_FADD:
 			    BUILD_TERM_REV(FUNCTOR_plus2);
 			    continue;
       case A_MUL:
+      case A_FMUL:
 			    BUILD_TERM_REV(FUNCTOR_star2);
 			    continue;
       case A_FUNC0:
       case A_FUNC1:
       case A_FUNC2:
+      case A_FSUB:
+      case A_FDIV:
 			    BUILD_TERM_REV(functorArithFunction((int)*PC++));
 			    continue;
       case A_FUNC:
@@ -6258,6 +6943,10 @@ decompileBodyNoShift(DECL_LD decompileInfo *di, code end, Code until)
       case C_JMP:
 			    PC++;
 			    continue;
+      case C_INLINE:			/* skip the inlined code */
+			    PC += *PC;
+			    PC += 3;
+			    continue;
       case L_NOLCO:
 			    PC += *PC;
 			    PC++;
@@ -7111,15 +7800,16 @@ PRED_IMPL("$xr_member", 2, xr_member, PL_FA_NONDETERMINISTIC)
   end = &PC[clause->code_size];
 
   if ( PL_is_variable(term) )
-  { int an;
+  { int an, sub;			/* sub: 2nd constant of CA1_DATA2 */
 
     if ( CTX_CNTRL != FRG_FIRST_CALL)
     { size_t i = CTX_INT;
 
-      PC += i >> 3;
+      PC += i >> 4;
+      sub = (int)(i>>3) & 0x1;
       an = (int)i & 0x7;
     } else
-    { an = 0;
+    { an = sub = 0;
     }
 
     for( ; PC < end; PC = stepPC(PC),an=0 )
@@ -7138,7 +7828,7 @@ PRED_IMPL("$xr_member", 2, xr_member, PL_FA_NONDETERMINISTIC)
 	  hit:
 	    if ( !rc )
 	      return false;		/* out of stack */
-	    i = ((PC - clause->codes)<<3) + an;
+	    i = ((PC - clause->codes)<<4) + (sub<<3) + an;
 	    ForeignRedoInt(i);
 	  }
 	  case CA1_FUNC:
@@ -7151,6 +7841,16 @@ PRED_IMPL("$xr_member", 2, xr_member, PL_FA_NONDETERMINISTIC)
 	    rc = PL_unify_atomic(term, xr);
 	    goto hit;
 	  }
+#ifdef O_CONST2
+	  case CA1_DATA2:
+	  { word xr = code2const(PC[an], sub);
+
+	    if ( (sub = !sub) )
+	      an--;			/* redo for the 2nd constant */
+	    rc = PL_unify_atomic(term, xr);
+	    goto hit;
+	  }
+#endif
 	  case CA1_MODULE:
 	  { Module xr = code2ptr(Module, PC[an]);
 	    rc = PL_unify_atom(term, xr->name);
@@ -7177,6 +7877,13 @@ PRED_IMPL("$xr_member", 2, xr_member, PL_FA_NONDETERMINISTIC)
 	      if ( PL_unify_atomic(term, code2word(PC[an])) )
 		succeed;
 	      break;
+#ifdef O_CONST2
+	    case CA1_DATA2:
+	      if ( PL_unify_atomic(term, code2const(PC[an], 0)) ||
+		   PL_unify_atomic(term, code2const(PC[an], 1)) )
+		succeed;
+	      break;
+#endif
 	    case CA1_MODULE:
 	    { Module xr = code2ptr(Module, PC[an]);
 
@@ -7263,6 +7970,7 @@ vm_list(Code start, Code end)
 	case I_FREDO:
 	case S_TRUSTME:
 	case S_LIST:
+	case S_ARGKEY:
 	  return;
       }
     }
@@ -7350,6 +8058,19 @@ unify_vmi(DECL_LD term_t t, Code bp)
 	{ rc = PL_unify_atomic(av+an, code2word(*bp++));
 	  break;
 	}
+#ifdef O_CONST2
+	case CA1_DATA2:
+	{ term_t c0 = PL_new_term_ref();
+	  term_t c1 = PL_new_term_ref();
+
+	  rc = ( c0 && c1 &&
+		 PL_unify_atomic(c0, code2const(*bp, 0)) &&
+		 PL_unify_atomic(c1, code2const(*bp, 1)) &&
+		 PL_unify_term(av+an, PL_LIST, 2, PL_TERM, c0, PL_TERM, c1) );
+	  bp++;
+	  break;
+	}
+#endif
 	case CA1_FUNC:
 	{ functor_t f = (functor_t) *bp++;
 	  rc = unify_functor(av+an, f, GP_NAMEARITY);
@@ -7469,6 +8190,7 @@ const char *ca1_name[] = {
   "lproc",
   "func",
   "data",
+  "data2",
   "integer",
   "int64",
   "float",
@@ -7597,6 +8319,48 @@ PRED_IMPL("$fetch_vm", 4, fetch_vm, PL_FA_TRANSPARENT)
 
 
 
+#ifdef O_VMI_PAIR_STATS
+/** '$vmi_pair_statistics'(-Pairs:list, +Clear:boolean)
+ *
+ * Pairs is a list of pair(VMI1, VMI2, Count), where Count is the number
+ * of times VMI2 was executed directly after VMI1.  VMI1 and VMI2 are
+ * the instruction names.  If Clear is `true`, the counts are reset.
+ * Only available if the system is built with VMI_PAIR_STATS.
+ */
+
+static
+PRED_IMPL("$vmi_pair_statistics", 2, vmi_pair_statistics, 0)
+{ PRED_LD
+  int clear;
+  term_t tail = PL_copy_term_ref(A1);
+  term_t head = PL_new_term_ref();
+
+  if ( !PL_get_bool_ex(A2, &clear) )
+    return false;
+
+  for(int i=0; i<I_HIGHEST; i++)
+  { for(int j=0; j<I_HIGHEST; j++)
+    { uint64_t count = vmi_pair_counts[i][j];
+
+      if ( count )
+      { if ( !PL_unify_list(tail, head, tail) ||
+	     !PL_unify_term(head,
+			    PL_FUNCTOR_CHARS, "pair", 3,
+			      PL_CHARS, codeTable[i].name,
+			      PL_CHARS, codeTable[j].name,
+			      PL_INT64, (int64_t)count) )
+	  return false;
+	if ( clear )
+	  vmi_pair_counts[i][j] = 0;
+      }
+    }
+  }
+
+  return PL_unify_nil(tail);
+}
+#endif /*O_VMI_PAIR_STATS*/
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 '$vm_assert'(+PIorClause, :VM, -Ref) is det.
 
@@ -7750,6 +8514,31 @@ vm_compile_instruction(term_t t, CompileInfo ci)
 	      Output_a(ci, word2code(val));
 	      break;
 	    }
+#ifdef O_CONST2
+	    case CA1_DATA2:
+	    { word val[2];
+	      term_t tail = PL_copy_term_ref(a);
+	      term_t head = PL_new_term_ref();
+
+	      for(int i=0; i<2; i++)
+	      { if ( !PL_get_list_ex(tail, head, tail) )
+		  fail;
+		val[i] = _PL_get_atomic(head);
+		if ( !isConst(val[i]) || !isConst32(val[i]) )
+		  return PL_error(NULL, 0, "must be a 32-bit constant",
+				  ERR_TYPE, ATOM_atomic, head);
+	      }
+	      if ( !PL_get_nil_ex(tail) )
+		fail;
+	      for(int i=0; i<2; i++)
+	      { if ( isAtom(val[i]) && !isNil(val[i]) )
+		  PL_register_atom(word2atom(val[i]));
+	      }
+
+	      Output_a(ci, consts2code(val[0], val[1]));
+	      break;
+	    }
+#endif
 	    case CA1_FUNC:
 	    { functor_t f;
 
@@ -7953,6 +8742,9 @@ find_if_then_end(Code PC, Code base)
       case C_NOT:
 	PC = nextpc + PC[2];
 	break;
+      case C_INLINE:
+	PC = nextpc + PC[1];
+	break;
       case C_SOFTIF:
       case C_IFTHENELSE:
       case C_FASTCOND:
@@ -8151,6 +8943,18 @@ PRED_IMPL("$clause_term_position", 3, clause_term_position, 0)
 
 	goto after_construct;
       }
+      case C_INLINE:	/* C_INLINE <jmp> <proc> <gen> <I> C_JMP <n> <Call> */
+      { Code callloc = nextpc + PC[1];
+
+	if ( loc <= callloc )		/* in the inlined code */
+	{ if ( PC[3] != INLINE_GEN_ANY )
+	    return PL_error(NULL, 0, "not a possible continuation",
+			    ERR_DOMAIN, ATOM_program_counter, A2);
+	  loc = callloc + callloc[-1];	/* folded call/N: return of <Call> */
+	}
+	PC = callloc;
+	continue;
+      }
       case C_SOFTIF:
       case C_IFTHENELSE:	/* C_IFTHENELSE <var> <jmp1> */
       case C_FASTCOND:		/* <IF> C_CUT <THEN> C_JMP <jmp2> <ELSE> */
@@ -8299,6 +9103,10 @@ PRED_IMPL("$break_pc", 3, break_pc, PL_FA_NONDETERMINISTIC)
   { code op = fetchop(PC);
     Code nextpc = stepPC(PC);
 
+    if ( op == C_INLINE )		/* never break in inlined code */
+    { PC = nextpc + PC[1];
+      continue;
+    }
     if ( (codeTable[op].flags & VIF_BREAK) )
     { switch(op)
       { case B_UNIFY_FIRSTVAR:
@@ -8525,6 +9333,437 @@ replacedBreak(Code PC)
 }
 
 
+		 /*******************************
+		 *	  GUARD INDEXING	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+If the body of a clause starts with a test on the head arguments, clause
+selection can often tell that the clause will fail without running it.
+For example, after selecting the first clause of max/3 for max(3,2,M) we
+do not need a choicepoint for the second.
+
+    max(X, Y, X) :- X >= Y.
+    max(X, Y, Y) :- X < Y.
+
+Such clauses are flagged CL_GUARD by setClauseGuard(). The guard is
+recognised from the VM code, so clauses loaded from a .qlf file are
+flagged as well.  A guard is the first goal of the body and one of
+
+  - A type test on a head argument except for nonvar/1
+  - ==/2 or \==/2 of two head arguments or a head argument and an atom
+    or small integer
+  - An arithmetic comparison of two head arguments or a head argument
+    and a small integer, either inlined (see O_COMPILE_ARITH) or as a
+    call.
+
+clauseGuardFails() tests the guard against the arguments of the call,
+i.e., before head unification.  As head unification may instantiate the
+arguments, we only claim failure if the guard also fails for any further
+instantiation of the arguments.  Otherwise, e.g., if an argument of an
+arithmetic comparison is unbound, the guard may succeed.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef enum
+{ GUARD_NONE = 0,			/* Not a guard */
+  GUARD_MAYBE,				/* Guard may succeed */
+  GUARD_FAILS				/* Guard surely fails */
+} guard_status;
+
+/* Get the argument accessed by a CA1_VAR operand.  Returns NULL if the
+ * variable is not a head argument.  If argv is NULL (compilation), we
+ * return a dummy non-NULL pointer.
+ */
+
+static Word
+guard_var(code v, size_t arity, Word argv)
+{ static word dummy;
+
+  if ( v < (code)VAROFFSET(0) || v >= (code)VAROFFSET(arity) )
+    return NULL;
+
+  return argv ? argv + (v-VAROFFSET(0)) : &dummy;
+}
+
+/* Decode an operand of an arithmetic comparison.  Returns the PC after
+ * the operand or NULL if it is not a head argument or small integer.
+ * `*nargs` is incremented for a head argument and `*known` is cleared if
+ * its value is not a small integer.
+ */
+
+#define guard_int(PC, arity, argv, ip, nargs, known) \
+	LDFUNC(guard_int, PC, arity, argv, ip, nargs, known)
+
+static Code
+guard_int(DECL_LD Code PC, size_t arity, Word argv, int64_t *ip,
+	  int *nargs, bool *known)
+{ code v;
+
+  switch(decode(*PC++))
+  { case A_VAR0:
+    case B_VAR0:
+      v = VAROFFSET(0);
+      break;
+    case A_VAR1:
+    case B_VAR1:
+      v = VAROFFSET(1);
+      break;
+    case A_VAR2:
+    case B_VAR2:
+      v = VAROFFSET(2);
+      break;
+    case A_VAR:
+    case B_VAR:
+      v = *PC++;
+      break;
+    case A_INTEGER:
+    case B_SMALLINT:
+      *ip = (scode)*PC++;
+      return PC;
+    default:
+      return NULL;
+  }
+
+  Word p;
+  if ( !(p=guard_var(v, arity, argv)) )
+    return NULL;
+  (*nargs)++;
+  if ( argv )
+  { deRef(p);
+    if ( isTaggedInt(*p) )
+      *ip = valInt(*p);
+    else
+      *known = false;
+  }
+
+  return PC;
+}
+
+static code
+arith_compare_vmi(const Definition def)
+{ if ( def->module == MODULE_system )
+  { functor_t f = def->functor->functor;
+
+    if ( f == FUNCTOR_smaller2 )       return A_LT;
+    if ( f == FUNCTOR_smaller_equal2 ) return A_LE;
+    if ( f == FUNCTOR_larger2 )        return A_GT;
+    if ( f == FUNCTOR_larger_equal2 )  return A_GE;
+    if ( f == FUNCTOR_ar_equals2 )     return A_EQ;
+    if ( f == FUNCTOR_ar_not_equal2 )  return A_NE;
+  }
+
+  return I_NOP;
+}
+
+/* Evaluate the guard of the clause whose code starts at PC.  If argv is
+ * NULL, only tell whether the clause has a guard.
+ */
+
+#define guardStatus(PC, arity, argv) LDFUNC(guardStatus, PC, arity, argv)
+
+static guard_status
+guardStatus(DECL_LD Code PC, size_t arity, Word argv)
+{ code op;
+  Word p1, p2;
+
+  for(;;)				/* skip the head */
+  { switch((op=decode(*PC)))
+    { case I_ENTER:
+	break;
+      case I_EXITFACT:
+      case I_EXIT:
+      case I_SSU_COMMIT:
+      case I_SSU_CHOICE:
+      case D_BREAK:
+	return GUARD_NONE;
+      default:
+	PC = stepPC(PC);
+	continue;
+    }
+    break;
+  }
+
+  PC++;
+  if ( decode(*PC) == L_NOLCO )		/* guard is the only goal */
+    PC += 2 + PC[1];
+
+  switch((op=decode(*PC)))
+  { case I_VAR:
+    case I_INTEGER:
+    case I_RATIONAL:
+    case I_FLOAT:
+    case I_NUMBER:
+    case I_ATOMIC:
+    case I_ATOM:
+    case I_STRING:
+    case I_COMPOUND:
+    case I_CALLABLE:
+    { bool ok;
+
+      if ( !(p1=guard_var(PC[1], arity, argv)) )
+	return GUARD_NONE;
+      if ( !argv )
+	return GUARD_MAYBE;
+      deRef(p1);
+      if ( canBind(*p1) )
+	return GUARD_MAYBE;
+
+      switch(op)
+      { case I_VAR:	 ok = false;		     break;
+	case I_INTEGER:	 ok = isInteger(*p1);	     break;
+	case I_RATIONAL: ok = isRational(*p1);	     break;
+	case I_FLOAT:	 ok = isFloat(*p1);	     break;
+	case I_NUMBER:	 ok = isNumber(*p1);	     break;
+	case I_ATOMIC:	 ok = isAtomic(*p1);	     break;
+	case I_ATOM:	 ok = isTextAtom(*p1);	     break;
+	case I_STRING:	 ok = isString(*p1);	     break;
+	case I_COMPOUND: ok = isTerm(*p1);	     break;
+	default:	 ok = isCallable(*p1);	     break;
+      }
+
+      return ok ? GUARD_MAYBE : GUARD_FAILS;
+    }
+    case B_EQ_VC:
+    case B_NEQ_VC:
+    { word c = code2word(PC[2]);
+
+      if ( !(p1=guard_var(PC[1], arity, argv)) )
+	return GUARD_NONE;
+      if ( !argv )
+	return GUARD_MAYBE;
+      deRef(p1);
+      if ( canBind(*p1) )
+	return GUARD_MAYBE;
+      if ( op == B_EQ_VC )
+	return *p1 == c ? GUARD_MAYBE : GUARD_FAILS;
+      else
+	return *p1 == c ? GUARD_FAILS : GUARD_MAYBE;
+    }
+    case B_EQ_VV:
+    case B_NEQ_VV:
+    { if ( !(p1=guard_var(PC[1], arity, argv)) ||
+	   !(p2=guard_var(PC[2], arity, argv)) )
+	return GUARD_NONE;
+      if ( !argv )
+	return GUARD_MAYBE;
+      deRef(p1);
+      deRef(p2);
+      if ( op == B_NEQ_VV )		/* identical terms remain identical */
+	return ( p1 == p2 || (*p1 == *p2 && !canBind(*p1))
+		 ? GUARD_FAILS : GUARD_MAYBE );
+      if ( (isAtom(*p1) || isTaggedInt(*p1)) &&
+	   (isAtom(*p2) || isTaggedInt(*p2)) &&
+	   *p1 != *p2 )
+	return GUARD_FAILS;
+      return GUARD_MAYBE;
+    }
+    case A_ENTER:
+      PC++;
+      /*FALLTHROUGH*/
+    default:
+    { int64_t i1 = 0, i2 = 0;
+      int nargs = 0;
+      bool known = true;
+
+      if ( !(PC=guard_int(PC, arity, argv, &i1, &nargs, &known)) ||
+	   !(PC=guard_int(PC, arity, argv, &i2, &nargs, &known)) ||
+	   nargs == 0 )
+	return GUARD_NONE;
+
+      switch((op=decode(*PC)))
+      { case I_CALL:
+	case I_DEPART:
+	  op = arith_compare_vmi(code2ptr(Procedure, PC[1])->definition);
+	  break;
+      }
+
+      bool holds;
+      switch(op)
+      { case A_LT: holds = i1 <  i2; break;
+	case A_LE: holds = i1 <= i2; break;
+	case A_GT: holds = i1 >  i2; break;
+	case A_GE: holds = i1 >= i2; break;
+	case A_EQ: holds = i1 == i2; break;
+	case A_NE: holds = i1 != i2; break;
+	default:
+	  return GUARD_NONE;
+      }
+
+      return !argv || !known || holds ? GUARD_MAYBE : GUARD_FAILS;
+    }
+  }
+}
+
+
+/* Set CL_GUARD if the body of `cl` starts with a guard.
+ */
+
+void
+setClauseGuard(DECL_LD Clause cl)
+{ if ( isoff(cl, CLAUSE_SSU_FLAGS|UNIT_CLAUSE|GOAL_CLAUSE) &&
+       guardStatus(cl->codes, cl->predicate->functor->arity, NULL) )
+    set(cl, CL_GUARD);
+}
+
+
+/* True if the guard of `cl` fails for the arguments in `argv`.
+ */
+
+bool
+clauseGuardFails(DECL_LD Clause cl, Word argv)
+{ return guardStatus(cl->codes, cl->predicate->functor->arity,
+		     argv) == GUARD_FAILS;
+}
+
+
+		 /*******************************
+		 *	     QUICKENING		*
+		 *******************************/
+
+#if O_QUICKEN
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+quickenPredicate() is called from I_ENTER  if the clauses of a predicate
+have been entered QUICKEN_THRESHOLD times.  It  rewrites instructions in
+the clauses of the predicate into  quickened  versions  that  have  the
+same  arguments and semantics, but assume the  types that are common in
+tight loops.  dewam_table[] maps quickened instructions to the original,
+so decompilation, GC, breakpoints and  .qlf  files  never  see them.  A
+quickened instruction  executes  the  original instruction if  its
+assumptions do not hold or we are debugging.
+
+As instructions are replaced by a single  aligned  store that preserves
+the semantics, this is safe while other threads execute the clause.  We
+use L_BREAK to avoid overwriting a D_BREAK set concurrently.
+
+Once quickened, the predicate  has  P_QUICKENED.   assertDefinition()
+quickens clauses added later using quickenClause(),  and I_ENTER does
+so for a clause that was added while quickenPredicate() was running.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+quick_operand_size(Code PC)
+{ switch(decode(*PC))
+  { case A_VAR:
+    case A_INTEGER:
+      return 2;
+    case A_VAR0:
+    case A_VAR1:
+    case A_VAR2:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static bool
+quick_arith(Code PC)
+{ int n;
+
+  if ( !(n=quick_operand_size(PC)) )
+    return false;
+  PC += n;
+  if ( !(n=quick_operand_size(PC)) )
+    return false;
+  PC += n;
+
+  switch(decode(*PC))
+  { case A_LT:
+    case A_LE:
+    case A_GT:
+    case A_GE:
+    case A_EQ:
+    case A_NE:
+      return true;
+    case A_ADD:
+    case A_MUL:
+      return decode(PC[1]) == A_FIRSTVAR_IS;
+    default:
+      return false;
+  }
+}
+
+static void
+quicken_clause(Clause cl)
+{ Code PC = cl->codes;
+  Code ep = PC + cl->code_size;
+
+  for( ; PC < ep; PC = stepPC_unlocked(PC) )
+  { switch(decode(*PC))
+    { case I_ENTER:
+	*PC = encode(I_ENTER_Q);
+	break;
+      case A_ENTER:
+	if ( quick_arith(PC+1) )
+	  *PC = encode(A_ENTER_Q);
+	break;
+    }
+  }
+}
+
+void
+quickenClause(Clause cl)
+{ PL_LOCK(L_BREAK);
+  quicken_clause(cl);
+  PL_UNLOCK(L_BREAK);
+}
+
+/* Called if the counter of I_ENTER has reached QUICKEN_THRESHOLD.  As
+ * the counter is not reset, several threads may get here.  Only the
+ * first does the work.  For thread-local predicates we only set the
+ * flag; I_ENTER quickens their clauses one by one.
+ */
+
+void
+quickenPredicate(DECL_LD Definition def)
+{ Definition old;
+
+  PL_LOCK(L_BREAK);
+  if ( ison(def, P_QUICKENED) )
+  { PL_UNLOCK(L_BREAK);
+    return;
+  }
+  set(def, P_QUICKENED);
+  if ( ison(def, P_FOREIGN|P_THREAD_LOCAL) )
+  { PL_UNLOCK(L_BREAK);
+    return;
+  }
+
+  acquire_def2(def, old);
+  for(ClauseRef c = def->impl.clauses.first_clause; c; c = c->next)
+  { Clause cl = c->value.clause;
+
+    if ( isoff(cl, CL_ERASED) )
+      quicken_clause(cl);
+  }
+  release_def2(def, old);
+  PL_UNLOCK(L_BREAK);
+}
+
+/** '$clause_quickened'(+ClauseRef) is semidet.
+ *
+ * True if the I_ENTER of ClauseRef has been quickened.  For testing.
+ */
+
+static
+PRED_IMPL("$clause_quickened", 1, clause_quickened, 0)
+{ Clause clause = NULL;
+  Code PC, ep;
+
+  if ( PL_get_clref(A1, &clause) != true )
+    return false;
+
+  PC = clause->codes;
+  ep = PC + clause->code_size;
+  for( ; PC < ep; PC = stepPC_unlocked(PC) )
+  { if ( *PC == encode(I_ENTER_Q) )
+      return true;
+  }
+
+  return false;
+}
+#endif /*O_QUICKEN*/
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 '$break_at'(+ClauseRef, +PC, +Bool) is det.
 
@@ -8671,4 +9910,10 @@ BeginPredDefs(comp)
   PRED_DEF("$current_break",	    2, current_break,	     NDET)
   PRED_DEF("$xr_member",	    2, xr_member,	     NDET)
 #endif /*O_DEBUGGER*/
+#ifdef O_VMI_PAIR_STATS
+  PRED_DEF("$vmi_pair_statistics",  2, vmi_pair_statistics,  0)
+#endif
+#if O_QUICKEN
+  PRED_DEF("$clause_quickened",	    1, clause_quickened,     0)
+#endif
 EndPredDefs
@@ -38,6 +38,8 @@
 #ifndef PL_COMP_H_INCLUDED
 #define PL_COMP_H_INCLUDED
 
+#define INLINE_GEN_ANY ((code)-1)	/* C_INLINE <gen> that always inlines */
+
 #if USE_LD_MACROS
 #define	initWamTable(_) LDFUNC(initWamTable, _)
 #define	get_head_and_body_clause(clause, head, body, m, flags) \
@@ -48,6 +50,9 @@
 	LDFUNC(assert_term, term, m, where, owner, loc, flags)
 #define	det_goal_error(fr, PC, found) LDFUNC(det_goal_error, fr, PC, found)
 #define unify_functor(t, fd, how) LDFUNC(unify_functor, t, fd, how)
+#define quickenPredicate(def) LDFUNC(quickenPredicate, def)
+#define setClauseGuard(cl) LDFUNC(setClauseGuard, cl)
+#define clauseGuardFails(cl, argv) LDFUNC(clauseGuardFails, cl, argv)
 #endif /*USE_LD_MACROS*/
 
 #define LDFUNC_DECLARATIONS
@@ -75,7 +80,8 @@ int		det_goal_error(LocalFrame fr, Code PC,
 			       atom_t found);
 Code		skipArgs(Code PC, int skip, int *in_hvoid);
 bool		argKey(Code PC, int skip, word *key);
-bool		arg1Key(Code PC, word *key);
+bool		argKeyAt(Code PC, int in_hvoid, word *key);
+bool		arg1Key(Code PC, int in_hvoid, word *key);
 const Code	prevPC(const Clause clause, const Code pc);
 bool		decompile(Clause clause, term_t term, term_t bindings);
 word		pl_nth_clause(term_t p, term_t n, term_t ref,
@@ -90,6 +96,10 @@ code		replacedBreakUnlocked(Code PC);
 int		clearBreakPointsClause(Clause clause) WUNUSED;
 bool		unify_functor(term_t t, functor_t fd, int how);
 void		vm_list(Code code, Code end);
+void		quickenPredicate(Definition def);
+void		quickenClause(Clause cl);
+void		setClauseGuard(Clause cl);
+bool		clauseGuardFails(Clause cl, Word argv);
 Module		clauseBodyContext(const Clause cl);
 
 #undef LDFUNC_DECLARATIONS
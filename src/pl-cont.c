@@ -318,11 +318,16 @@ put_continuation(term_t cont, LocalFrame resetfr, LocalFrame fr, Code pc,
       fr_ref = consTermRef(fr);
 
       if ( (env_f=env3_predicate(fr->predicate)) )
-      { term_t av = PL_new_term_refs(2);
+      { term_t av = PL_new_term_refs(3);
 
 	fr = (LocalFrame)valTermRef(fr_ref);
 	PL_put_term(av+0, consTermRef(argFrameP(fr, 1)));
 	PL_put_term(av+1, consTermRef(argFrameP(fr, 2)));
+	if ( env_f == FUNCTOR_catch3 )	/* catch/3 does not qualify */
+	{ PL_put_atom(av+2, contextModule(fr)->name);
+	  if ( !PL_cons_functor(av+1, FUNCTOR_colon2, av+2, av+1) )
+	    return false;
+	}
 
 	if ( PL_cons_list_v(contv, depth, contv) &&
 	     PL_cons_functor(contv, FUNCTOR_call_continuation1, contv) &&
@@ -139,6 +139,7 @@ Marking, testing marks and extracting values from GC masked words.
 #define	marks_swept	   (LD->gc._marks_swept)
 #define	marks_unswept	   (LD->gc._marks_unswept)
 #define	alien_relocations  (LD->gc._alien_relocations)
+#define gc_base		   (LD->gc._gc_base)
 #define local_frames	   (LD->gc._local_frames)
 #define choice_count	   (LD->gc._choice_count)
 #define start_map	   (LD->gc._start_map)
@@ -224,6 +225,7 @@ domark(DECL_LD Word p)
 }
 
 #define get_value(p)	(*(p) & VALUE_MASK)
+#define is_marked_or_old(p) (is_marked(p) || (p) < gc_base)
 #define set_value(p, w)	do { *(p) &= GC_MASK; *(p) |= w; } while(0)
 
 #define inShiftedArea(area, shift, ptr) \
@@ -613,9 +615,11 @@ last_gc_stats(gc_stats *stats)
 { return &stats->last[STAT_PREV_INDEX(stats->last_index)];
 }
 
-/** '$gc_statistics'(-Stats)
+/** '$gc_statistics'(-Recent, -Aggregated, -LastPrec, -Last3, -Last9,
+ *		      -Minor, -Major)
  *
- * Stats = gc_stats(Recent, Aggregated, LastPrec, Last3, Last9)
+ * Minor and Major are the number of minor (young generation only) and
+ * major collections.
  */
 
 static double
@@ -688,17 +692,20 @@ unify_gc_stats(DECL_LD term_t t, gc_stat *stats, int index)
 
 
 static
-PRED_IMPL("$gc_statistics", 5, gc_statistics, 0)
+PRED_IMPL("$gc_statistics", 7, gc_statistics, 0)
 { PRED_LD
   gc_stats *stats = &LD->gc.stats;
   gc_stat  *last  = last_gc_stats(stats);
   gc_stat  *aggr  = &stats->aggr[STAT_PREV_INDEX(stats->aggr_index)];
+  int64_t   minor = stats->totals.minor_collections;
 
   return ( unify_gc_stats(A1, stats->last, stats->last_index) &&
 	   unify_gc_stats(A2, stats->aggr, stats->aggr_index) &&
 	   PL_unify_float(A3, gc_percentage(last)) &&
 	   PL_unify_float(A4, gc_percentage(aggr)) &&
-	   PL_unify_float(A5, gc_avg(stats))
+	   PL_unify_float(A5, gc_avg(stats)) &&
+	   PL_unify_int64(A6, minor) &&
+	   PL_unify_int64(A7, stats->totals.collections - minor)
 	 );
 }
 
@@ -847,6 +854,10 @@ supposed to hold:
       number is only used for consistency checking with the relocation
       statistic obtained during the compacting phase.
 
+During a minor collection, cells below `gc_base'   belong  to  the old
+generation. They are not marked and  the   marker  does not walk into
+them. See garbageCollect().
+
 The marking algorithm forms a two-state machine. While going deeper into
 the reference tree, the pointers are reversed  and the FIRST_MASK is set
 to indicate the choice points created by   complex terms with arity > 1.
@@ -891,6 +902,8 @@ forward:				/* Go into the tree */
   { case TAG_REFERENCE:
     { next = unRef(val);		/* address pointing to */
       DEBUG(CHK_SECURE, assert(onStack(global, next)));
+      if ( next < gc_base )		/* old generation (minor GC) */
+	BACKWARD;
       needsRelocation(current);
       if ( is_first(next) )		/* ref to choice point. we will */
 	BACKWARD;			/* get there some day anyway */
@@ -906,6 +919,8 @@ forward:				/* Go into the tree */
     { DEBUG(CHK_SECURE, assert(storage(val) == STG_GLOBAL));
       next = valPtr(val);
       DEBUG(CHK_SECURE, assert(onStack(global, next)));
+      if ( next < gc_base )
+	BACKWARD;
       needsRelocation(current);
       if ( is_marked(next) )
 	BACKWARD;			/* term has already been marked */
@@ -924,6 +939,8 @@ forward:				/* Go into the tree */
       DEBUG(CHK_SECURE, assert(storage(val) == STG_GLOBAL));
       next = valPtr(val);
       DEBUG(CHK_SECURE, assert(onStack(global, next)));
+      if ( next < gc_base )
+	BACKWARD;
       needsRelocation(current);
       if ( is_marked(next) )
 	BACKWARD;			/* term has already been marked */
@@ -955,6 +972,8 @@ forward:				/* Go into the tree */
 
       DEBUG(CHK_SECURE, assert(storage(val) == STG_GLOBAL));
       DEBUG(CHK_SECURE, assert(onStack(global, next)));
+      if ( next < gc_base )
+	BACKWARD;
       needsRelocation(current);
       if ( is_marked(next) )		/* can be referenced from multiple */
 	BACKWARD;			/* places */
@@ -1359,6 +1378,7 @@ clearUninitialisedVarsFrame(LocalFrame fr, Code PC)
 	case I_FREDO:
 	case S_TRUSTME:
 	case S_LIST:
+	case S_ARGKEY:
 	  return;
 
 	case C_JMP:			/* jumps */
@@ -1582,12 +1602,12 @@ early_reset_vars(DECL_LD mark *m, Word top, TrailEntry te)
 	te--;
 	te->as_word = 0;
 	trailcells_deleted += 2;
-      } else if ( is_marked(tard) )
+      } else if ( is_marked_or_old(tard) )
       {
       keep:
 	assert(onGlobal(gp));
 	assert(!is_first(gp));
-	if ( !is_marked(gp) )
+	if ( gp >= gc_base && !is_marked(gp) )
 	{ DEBUG(MSG_GC_ASSIGNMENTS_MARK,
 		char b1[64]; char b2[64]; char b3[64];
 		Sdprintf("Marking assignment at %s (%s --> %s)\n",
@@ -1636,11 +1656,11 @@ early_reset_vars(DECL_LD mark *m, Word top, TrailEntry te)
 	trailcells_deleted++;
       } else if ( tard > gKeep && tard < gMax )
       { if ( LD->attvar.attvars &&	/* see (**) */
-	     is_marked(tard) && isRef(*tard) &&
+	     is_marked_or_old(tard) && isRef(*tard) &&
 	     te-1 >= tm )
 	{ Word tard2 = valPtr(te[-1].as_word);
 
-	  if ( is_marked(tard2) && isAttVar(*tard2) )
+	  if ( is_marked_or_old(tard2) && isAttVar(*tard2) )
 	  { te--;
 	    DEBUG(MSG_GC_RESET,
 		  Sdprintf("Keep trail for attvar _%lld\n",
@@ -1650,7 +1670,7 @@ early_reset_vars(DECL_LD mark *m, Word top, TrailEntry te)
 	}
 	te->as_word = 0;
 	trailcells_deleted++;
-      } else if ( !is_marked(tard) )
+      } else if ( !is_marked_or_old(tard) )
       { DEBUG(MSG_GC_RESET,
 	      char b1[64]; char b2[64];
 	      Sdprintf("Early reset at %s (%s)\n",
@@ -2006,6 +2026,7 @@ walk_and_mark(DECL_LD walk_state *state, Code PC, code end)
       case I_FEXITNDET:
       case S_TRUSTME:			/* Consider supervisor handling! */
       case S_LIST:
+      case S_ARGKEY:
 	return PC-1;
       case I_FREDO:
 	mark_arguments(state->frame);
@@ -2030,6 +2051,17 @@ walk_and_mark(DECL_LD walk_state *state, Code PC, code end)
 	op = decode(*PC++);
 	goto again;
       }
+      case C_INLINE:
+	if ( (state->flags & GCM_ALTCLAUSE) )
+	  break;
+      { Code alt = PC+PC[0]+3;
+	DEBUG(MSG_GC_WALK, Sdprintf("C_INLINE at %d\n", PC-state->c0-1));
+	PC += 3;			/* skip <jmp>, <proc> and <gen> */
+	walk_and_mark(state, PC, C_JMP);
+	PC = alt;
+	op = decode(*PC++);
+	goto again;
+      }
       case C_NOT:
       case C_DET:
 	if ( (state->flags & GCM_ALTCLAUSE) )
@@ -2206,6 +2238,10 @@ walk_and_mark(DECL_LD walk_state *state, Code PC, code end)
 	case H_FLOAT:
 	  mark_argp(state);
 	  break;
+	case H_CONST2:
+	  mark_argp(state);
+	  mark_argp(state);
+	  break;
 	case H_FUNCTOR:
 	case H_LIST:
 	  mark_argp(state);
@@ -2579,11 +2615,66 @@ cmp_address(const void *vp1, const void *vp2)
 #endif
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+The remembered set of a  minor  collection.   A  cell  of  the  old
+generation can only refer to the young  generation through a binding
+made after the previous collection.  As   LD->mark_bar  is  kept at or
+above LD->young_bar, such bindings are   trailed.  Trailed old cells
+that refer to the young generation are   thus  roots. They are marked
+to process them only once and pushed on `remembered' such that we can
+insert them into the relocation chains  in collect_phase(). We cannot
+use the trail for that as early_reset_vars() may delete entries.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define is_young_ref(w) LDFUNC(is_young_ref, w)
+static inline int
+is_young_ref(DECL_LD word w)
+{ return isGlobalRef(w) && valPtr(w) >= gc_base;
+}
+
+#define mark_remembered_set(remembered) LDFUNC(mark_remembered_set, remembered)
 static void
-mark_phase(vm_state *state)
+mark_remembered_set(DECL_LD segstack *remembered)
+{ TrailEntry te;
+
+  for(te = tBase; te < tTop; te++)
+  { word w = te->as_word;
+
+    if ( w && ttag(w) != TAG_TRAILVAL && storage(w) == STG_GLOBAL )
+    { Word p = valPtr(w);
+
+      if ( p < gc_base && !is_marked(p) && is_young_ref(get_value(p)) )
+      { mark_variable(p);
+	total_marked--;			/* p itself is not moved */
+	if ( !pushSegStack(remembered, p, Word) )
+	  outOfCore();
+      }
+    }
+  }
+}
+
+
+#define relocate_remembered_set(remembered) \
+	LDFUNC(relocate_remembered_set, remembered)
+static void
+relocate_remembered_set(DECL_LD segstack *remembered)
+{ Word p;
+
+  while( popSegStack(remembered, &p, Word) )
+  { clear_marked(p);
+    check_relocation(p);
+    into_relocation_chain(p, STG_GLOBAL);
+  }
+}
+
+
+static void
+mark_phase(vm_state *state, segstack *remembered)
 { GET_LD
   total_marked = 0;
 
+  if ( gc_base > gBase )
+    mark_remembered_set(remembered);
   DEBUG(CHK_SECURE, check_marked("Before mark_term_refs()"));
   mark_term_refs();
   mark_stacks(state);
@@ -2935,6 +3026,10 @@ sweep_global_mark(DECL_LD gc_wordptr *m)
   DEBUG(CHK_SECURE, assert(onStack(local, m)));
   IS_WORD_ALIGNED(gm);
 
+  if ( gm <= gc_base )			/* old generation does not move */
+  { m->as_word = consPtr(gm, STG_GLOBAL);
+    return;
+  }
   if ( is_marked_or_first(gm-1) )
     goto done;				/* quit common easy case */
 
@@ -3012,8 +3107,10 @@ sweep_foreign(void)
       {	clear_marked(sp);
 	if ( isGlobalRef(get_value(sp)) )
 	{ processLocal(sp);
-	  check_relocation(sp);
-	  into_relocation_chain(sp, STG_LOCAL);
+	  if ( is_young_ref(get_value(sp)) )
+	  { check_relocation(sp);
+	    into_relocation_chain(sp, STG_LOCAL);
+	  }
 	}
       }
     }
@@ -3094,12 +3191,14 @@ sweep_trail(void)
     {
 #ifdef O_DESTRUCTIVE_ASSIGNMENT
       if ( ttag(te->as_word) == TAG_TRAILVAL )
-      { needsRelocation(&te->as_word);
-	check_relocation(&te->as_word);
-	into_relocation_chain(&te->as_word, STG_TRAIL);
+      { if ( valPtr(te->as_word) >= gc_base )
+	{ needsRelocation(&te->as_word);
+	  check_relocation(&te->as_word);
+	  into_relocation_chain(&te->as_word, STG_TRAIL);
+	}
       } else
 #endif
-      if ( storage(te->as_word) == STG_GLOBAL )
+      if ( is_young_ref(te->as_word) )
       { needsRelocation(&te->as_word);
 	check_relocation(&te->as_word);
 	into_relocation_chain(&te->as_word, STG_TRAIL);
@@ -3121,8 +3220,10 @@ sweep_frame(DECL_LD LocalFrame fr, int slots)
     { clear_marked(sp);
       if ( isGlobalRef(get_value(sp)) )
       { processLocal(sp);
-	check_relocation(sp);
-	into_relocation_chain(sp, STG_LOCAL);
+	if ( is_young_ref(get_value(sp)) )
+	{ check_relocation(sp);
+	  into_relocation_chain(sp, STG_LOCAL);
+	}
       }
     } else
     { word w = *sp;
@@ -3198,8 +3299,10 @@ sweep_new_arguments(DECL_LD vm_state *state)
       clear_marked(sp);
       if ( isGlobalRef(get_value(sp)) )
       { processLocal(sp);
-	check_relocation(sp);
-	into_relocation_chain(sp, STG_LOCAL);
+	if ( is_young_ref(get_value(sp)) )
+	{ check_relocation(sp);
+	  into_relocation_chain(sp, STG_LOCAL);
+	}
       }
     }
   }
@@ -3298,7 +3401,7 @@ is_downward_ref(DECL_LD Word p)
 
       DEBUG(CHK_SECURE, assert(d >= gBase));
 
-      return d < p;
+      return d < p && d >= gc_base;
     }
   }
 
@@ -3417,7 +3520,7 @@ static void
 compact_global(void)
 { GET_LD
   Word dest, current;
-  Word base = gBase, top;
+  Word base = gc_base, top;
 #if O_DEBUG
   Word *v = mark_top;
 #endif
@@ -3475,8 +3578,8 @@ compact_global(void)
 	});
 
   if ( dest != base )
-    sysError("Mismatch in down phase: dest = %p, gBase = %p\n",
-	     dest, gBase);
+    sysError("Mismatch in down phase: dest = %p, base = %p\n",
+	     dest, base);
   if ( relocation_cells != relocated_cells )
   { DEBUG(CHK_SECURE, printNotRelocated());
     sysError("After down phase: relocation_cells = %ld; relocated_cells = %ld",
@@ -3489,7 +3592,7 @@ compact_global(void)
 
   dest = base;
   top = gTop;
-  for(current = gBase; current < top; )
+  for(current = base; current < top; )
   { if ( is_marked(current) )
     { intptr_t l, n;
 
@@ -3528,9 +3631,9 @@ compact_global(void)
     }
   }
 
-  if ( dest != gBase + total_marked )
-    sysError("Mismatch in up phase: dest = %p, gBase+total_marked = %p\n",
-	     dest, gBase + total_marked );
+  if ( dest != base + total_marked )
+    sysError("Mismatch in up phase: dest = %p, base+total_marked = %p\n",
+	     dest, base + total_marked );
 
   DEBUG(CHK_SECURE,
 	{ Word p = dest;		/* clear top of stack */
@@ -3542,12 +3645,23 @@ compact_global(void)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+In a minor collection we set the  mark   of  the  last cell of the old
+generation.  This stops the backward scans   of sweep_global_mark() and
+downskip_combine_garbage() at the  bottom  of   the  young  generation.
+compact_global() only considers cells from gc_base.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
 static void
-collect_phase(vm_state *state, gc_wordptr *saved_bar_at)
+collect_phase(vm_state *state, gc_wordptr *saved_bar_at, segstack *remembered)
 { GET_LD
 
   DEBUG(CHK_SECURE, check_marked("Start collect"));
 
+  relocate_remembered_set(remembered);
+  if ( gc_base > gBase )
+    set_marked(gc_base-1);
+
   DEBUG(MSG_GC_PROGRESS, Sdprintf("Sweeping foreign references\n"));
   sweep_foreign();
   DEBUG(MSG_GC_PROGRESS, Sdprintf("Sweeping trail stack\n"));
@@ -3560,6 +3674,8 @@ collect_phase(vm_state *state, gc_wordptr *saved_bar_at)
   }
   DEBUG(MSG_GC_PROGRESS, Sdprintf("Compacting global stack\n"));
   compact_global();
+  if ( gc_base > gBase )
+    clear_marked(gc_base-1);
 
   unsweep_foreign();
   unsweep_stacks(state);
@@ -3657,6 +3773,10 @@ setStartOfVMI(vm_state *state)
 	  if ( state->adepth == 0 )
 	    state->argp += PC[1];
 	  break;
+	case H_CONST2:
+	  if ( state->adepth == 0 )
+	    state->argp += 2;
+	  break;
 
 	case B_UNIFY_VAR:
 	case B_UNIFY_FIRSTVAR:
@@ -4374,6 +4494,55 @@ gcEnsureSpace(DECL_LD vm_state *state)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+gc_young_base() decides between a  minor   and  a major collection.  If
+the Prolog flag `gc_generational` is  true,   the  cells created before
+the previous collection (LD->young_bar) are   assumed to be alive and a
+minor collection only  compacts  the  cells   above  it.  As  the  old
+generation contains garbage as well, we   do  a major collection if it
+has doubled since the last major collection,  if we run out of space or
+on explicit requests and exceptions.
+
+Returns the bottom of the area to collect.
+
+A collection due to a stack overflow  may   run  in  the  middle of a
+sequence of H_* or B_* instructions that write  a term. The VM then fills
+the remaining arguments using plain writes that are not trailed. We may
+thus not promote the young generation after such a collection. A minor
+collection keeps the current bar and a   major  collection drops it. The
+next collection at a safe point promotes the survivors.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define gc_young_base(_) LDFUNC(gc_young_base, _)
+static Word
+gc_young_base(DECL_LD)
+{ gc_stat *this = &LD->gc.stats.last[LD->gc.stats.last_index];
+  gc_reason_t reason = this->reason;
+  Word young = LD->young_bar;
+
+  if ( !young || !truePrologFlag(PLFLAG_GC_GENERATIONAL) )
+    return gBase;
+  if ( (reason & (GC_EXCEPTION*0xff|GC_USER*0xff)) )
+    return gBase;
+  DEBUG(CHK_SECURE, return gBase);
+
+  if ( LD->frozen_bar > young )
+    young = LD->frozen_bar;
+  if ( young <= gBase || young >= gTop )
+    return gBase;
+  if ( (size_t)((char*)young - (char*)gBase) > 2*LD->gc.major_global )
+    return gBase;
+  if ( (reason & (GC_GLOBAL_OVERFLOW*0xff|GC_TRAIL_OVERFLOW*0xff)) )
+  { size_t limit = sizeStackP(&GD->combined_stack) - usedStack(local);
+
+    if ( usedStack(global) + usedStack(trail) > limit/2 )
+      return gBase;
+  }
+
+  return young;
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 garbageCollect() returns one of true (ok),   false (blocked or exception
 in printMessage()) or *_OVERFLOW if the   local  stack cannot accomodate
@@ -4407,9 +4576,12 @@ garbageCollect(gc_reason_t reason)
   term_t preShiftLTop;			/* safe over trimStacks() (shift) */
   int verbose = truePrologFlag(PLFLAG_TRACE_GC) && !LD->in_print_message;
   int no_mark_bar;
+  int minor;
   int rc;
   fid_t gvars, astack, attvars;
   gc_wordptr *saved_bar_at;		/* LD->frozen_bar placed on top of local stack */
+  Word rbuf[256];
+  segstack remembered;			/* old cells that refer to young ones */
 #ifdef O_PROFILE
   struct call_node *prof_node = NULL;
 #endif
@@ -4445,6 +4617,9 @@ garbageCollect(gc_reason_t reason)
 
   if ( (no_mark_bar=(LD->mark_bar == NO_MARK_BAR)) )
     LD->mark_bar = gTop;		/* otherwise we cannot relocate */
+  gc_base = gc_young_base();
+  minor = (gc_base > gBase);
+  initSegStack(&remembered, sizeof(Word), sizeof(rbuf), rbuf);
 
 #ifdef O_PROFILE
   if ( LD->profile.active )
@@ -4491,11 +4666,12 @@ garbageCollect(gc_reason_t reason)
   save_grefs();
   DEBUG(CHK_SECURE, check_foreign());
   tag_trail();
-  mark_phase(&state);
+  mark_phase(&state, &remembered);
 
   DEBUG(MSG_GC_PROGRESS, Sdprintf("Compacting trail\n"));
   compact_trail();
-  collect_phase(&state, saved_bar_at);
+  collect_phase(&state, saved_bar_at, &remembered);
+  discardSegStack(&remembered);
   restore_grefs();
   untag_trail();
   clean_attvar_chain();
@@ -4504,6 +4680,24 @@ garbageCollect(gc_reason_t reason)
   term_refs_to_argument_stack(&state, astack);
   restore_attvars(attvars);
 
+  if ( truePrologFlag(PLFLAG_GC_GENERATIONAL) )
+  { if ( !(reason & (GC_GLOBAL_OVERFLOW*0xff|GC_TRAIL_OVERFLOW*0xff)) )
+    { LD->young_bar = gTop;		/* see DiscardMark() */
+      LD->mark_bar = gTop;
+    } else
+    { if ( !minor )
+	LD->young_bar = NULL;		/* see gc_young_base() */
+      if ( LD->mark_bar > gTop )
+	LD->mark_bar = gTop;
+    }
+  } else if ( LD->young_bar )
+  { LD->young_bar = NULL;
+    if ( LD->mark_bar > gTop )
+      LD->mark_bar = gTop;
+  }
+  if ( !minor )
+    LD->gc.major_global = usedStack(global);
+
   assert(LD->mark_bar <= gTop);
 
   DEBUG(CHK_SECURE,
@@ -4545,9 +4739,12 @@ garbageCollect(gc_reason_t reason)
   leaveGC();
 
   stats = gc_stat_end(&LD->gc.stats);
+  if ( minor )
+    LD->gc.stats.totals.minor_collections++;
 
   if ( verbose )
-    Sdprintf("gained (g+t) %zd+%zd in %.3f sec; used %zd+%zd; free %zd+%zd\n",
+    Sdprintf("%sgained (g+t) %zd+%zd in %.3f sec; used %zd+%zd; free %zd+%zd\n",
+	     minor ? "minor; " : "",
 	     stats->global_before - stats->global_after,
 	     stats->trail_before  - stats->trail_after,
 	     stats->gc_time,
@@ -5069,6 +5266,9 @@ update_gvars(intptr_t gs)
   if ( LD->frozen_bar )
   { update_pointer(&LD->frozen_bar, gs);
   }
+  if ( LD->young_bar )
+  { update_pointer(&LD->young_bar, gs);
+  }
   if ( LD->attvar.attvars )
   { update_pointer(&LD->attvar.attvars, gs);
   }
@@ -5907,7 +6107,7 @@ markPredicatesInEnvironments(PL_local_data_t *ld, void *ctx)
 		 *******************************/
 
 BeginPredDefs(gc)
-  PRED_DEF("$gc_statistics", 5, gc_statistics, 0)
+  PRED_DEF("$gc_statistics", 7, gc_statistics, 0)
 #if O_DEBUG || defined(O_MAINTENANCE)
   PRED_DEF("$check_stacks", 1, check_stacks, 0)
 #endif
@@ -396,6 +396,12 @@ struct PL_global_data
     float	min_speedup_ratio;
     int		max_lookahead;
     int		min_clauses;
+    int		fill_threads;
+    int		fill_workers;		/* Running index fill helpers */
+    int		fill_min_clauses;
+    int		bloom_bits;
+    int		sample;			/* Sample 1 in N calls (0: off) */
+    TableWP	advice;			/* Definition --> index_advice */
   } clause_index;
 
   struct
@@ -488,6 +494,7 @@ struct PL_local_data
 #ifdef O_GVAR
   Word		frozen_bar;		/* Frozen part of the global stack */
 #endif
+  Word		young_bar;		/* Bottom of the young generation */
   Code		fast_condition;		/* Fast condition support */
   pl_stacks_t   stacks;			/* Prolog runtime stacks */
   int		alerted;		/* Special mode. See updateAlerted() */
@@ -604,6 +611,11 @@ struct PL_local_data
     int		warnings;		/* Printed warning messages */
   } statistics;
 
+  struct
+  { int		sample_tick;		/* Countdown to next index sample */
+    uint32_t	sample_seed;		/* Random state for sampling */
+  } clause_index;
+
 #ifdef O_BIGNUM
   struct
   { ar_context *context;		/* current allocation context */
@@ -873,11 +885,13 @@ struct PL_local_data
     size_t _marks_swept;		/* # marks swept */
     size_t _marks_unswept;		/* # marks swept */
     size_t _alien_relocations;		/* # alien_into_relocation_chain() */
+    Word   _gc_base;			/* Bottom of the collected area */
     size_t _local_frames;		/* frame count for debugging */
     size_t _choice_count;		/* choice-point count for debugging */
     int  *_start_map;			/* bitmap with legal global starts */
     sigset_t saved_sigmask;		/* Saved signal mask */
     int64_t inferences;			/* #inferences at last GC */
+    size_t major_global;		/* global stack after last major GC */
     pl_gc_status_t	status;		/* Garbage collection status */
 #ifdef O_CALL_RESIDUE
     int			marked_attvars;	/* do not GC attvars */
@@ -904,6 +918,12 @@ struct PL_local_data
   { int		return_code;		/* SOLUTION_RETURN() */
   } vm;
 #endif
+
+#ifdef O_VMI_PAIR_STATS
+  struct
+  { code	prev;			/* Previous executed VMI */
+  } vmi_stats;
+#endif
 };
 
 GLOBAL PL_global_data_t PL_global_data;
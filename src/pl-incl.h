@@ -165,7 +165,15 @@ handy for it someone wants to add a data type to the system.
       prolog  compiler  to put the  code  (=  label-) addresses in the
       compiled Prolog  code  rather than the  virtual-machine numbers.
       This speeds-up  the vm  instruction dispatching in  interpret().
-      See also pl-comp.c
+      See also pl-comp.c.  Disabled using -DDIRECT_THREADING=OFF
+  VMI_TOKEN_THREADING
+      Set if O_LABEL_ADDRESSES is set and -DDIRECT_THREADING=OFF.
+      Compiled code holds VM instruction numbers, but each instruction
+      dispatches the next one through its own `goto *table[code]'
+      rather than a shared switch.
+  O_QUICKEN
+      Rewrite instructions of hot predicates into specialised versions
+      (see quickenPredicate()).  Requires VMCODE_IS_ADDRESS.
   O_LOGICAL_UPDATE
       Use `logical' update-view for dynamic predicates rather then the
       `immediate' update-view of older Prolog systems.
@@ -300,10 +308,24 @@ The ia64 says setjmp()/longjmp() buffer must be aligned at 128 bits
 #endif
 
 /* clang as of version 11 performs about 30% worse with this option */
-#if O_LABEL_ADDRESSES && !defined(VMCODE_IS_ADDRESS) && !defined(__llvm__)
+#if O_LABEL_ADDRESSES && O_DIRECT_THREADING && \
+    !defined(VMCODE_IS_ADDRESS) && !defined(__llvm__)
 #define VMCODE_IS_ADDRESS	1
 #endif
 
+#if O_LABEL_ADDRESSES && !O_DIRECT_THREADING && !VMCODE_IS_ADDRESS && \
+    !O_VMI_FUNCTIONS
+#define VMI_TOKEN_THREADING	1
+#endif
+
+/* Quickened instructions are mapped back to their base instruction by
+ * dewam_table[], which makes them invisible to the rest of the system.
+ */
+#if VMCODE_IS_ADDRESS && !defined(O_QUICKEN)
+#define O_QUICKEN		1
+#define QUICKEN_THRESHOLD	1000	/* I_ENTER calls before quickening */
+#endif
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Runtime version.  Uses somewhat less memory and has no tracer.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -823,6 +845,7 @@ typedef struct clause *		Clause;		/* compiled clause */
 typedef struct clause_ref *	ClauseRef;      /* reference to a clause */
 typedef struct clause_index *	ClauseIndex;    /* Clause indexing table */
 typedef struct clause_bucket *	ClauseBucket;   /* Bucked in clause-index table */
+typedef struct range_index *	RangeIndex;	/* Ordered clause index */
 typedef struct operator *	Operator;	/* see pl-op.c, pl-read.c */
 typedef struct record *		Record;		/* recorda/3, etc. */
 typedef struct recordRef *	RecordRef;      /* reference to a record */
@@ -872,6 +895,18 @@ ptr2word(void *ptr)
 #define word2code(w)	  ((code)(w))
 #define code2word(c)	  ((word)(sword)(scode)(c))
 
+/* H_CONST2 packs two head constants (atoms or small integers) in a
+ * single code if both words are the sign extension of their low 32
+ * bits.  This is only possible if a code has 64 bits.
+ */
+#if SIZEOF_CODE == 8
+#define O_CONST2 1
+#define isConst32(w)	  ((word)(sword)(int32_t)(w) == (w))
+#define consts2code(w0, w1) \
+	((code)(uint32_t)(w0) | (code)(w1)<<32)
+#define code2const(c, i)  ((word)(sword)(int32_t)((c)>>((i)*32)))
+#endif
+
 
 		 /*******************************
 		 *	    ARITHMETIC		*
@@ -1041,6 +1076,7 @@ with one operation, it turns out to be faster as well.
 #define P_REDEFINED		FLAG64(33) /* Overrules a definition */
 #define P_SIG_ATOMIC		FLAG64(34) /* Do not call handleSignals */
 #define P_TRANSACT		FLAG64(35) /* Subject to transactions */
+#define P_QUICKENED		FLAG64(40) /* Clauses are quickened (O_QUICKEN) */
 #define PROC_DEFINED		(P_DYNAMIC|P_FOREIGN|P_MULTIFILE|\
 				 P_DISCONTIGUOUS|P_LOCKED_SUPERVISOR)
 #define P_RELOADING		P_MODIFIED /* We are reloading */
@@ -1064,6 +1100,8 @@ with one operation, it turns out to be faster as well.
 #define SSU_COMMIT_CLAUSE	(0x0100) /* Head => Body */
 #define SSU_CHOICE_CLAUSE	(0x0200) /* Head ?=> Body */
 #define CL_HEAD_TERMS		(0x0400) /* Head contains terms used in body */
+#define CL_INLINED		(0x0800) /* Body has inlined calls */
+#define CL_GUARD		(0x1000) /* Body starts with a guard */
 
 #define CLAUSE_TYPE_MASK (UNIT_CLAUSE|SSU_COMMIT_CLAUSE|SSU_CHOICE_CLAUSE)
 #define CLAUSE_SSU_FLAGS (SSU_COMMIT_CLAUSE|SSU_CHOICE_CLAUSE)
@@ -1473,6 +1511,7 @@ typedef struct clause_list
   ClauseRef	first_clause;		/* clause list of procedure */
   ClauseRef	last_clause;		/* last clause of list */
   ClauseIndex  *clause_indexes;		/* Hash index(es) */
+  RangeIndex	range_indexes;		/* Ordered index(es) */
   unsigned int	number_of_clauses;	/* number of associated clauses */
   unsigned int	erased_clauses;		/* number of erased clauses in set */
   unsigned int	number_of_rules;	/* number of real rules */
@@ -1536,6 +1575,7 @@ typedef struct gc_stats
   gc_reason_t	request;		/* Requesting stack */
   struct
   { int64_t	collections;
+    int64_t	minor_collections;	/* only collected the young generation */
     int64_t	global_gained;		/* global stack bytes collected */
     int64_t	trail_gained;		/* trail stack bytes collected */
     double	time;			/* time spent in collections */
@@ -1551,6 +1591,7 @@ typedef enum vm_arg_type
   CA1_LPROC,		/* Procedure, stored in qlf as functor */
   CA1_FUNC,		/* functor_t */
   CA1_DATA,		/* word: atom or small int */
+  CA1_DATA2,		/* Two 32-bit CA1_DATA (see consts2code()) */
   CA1_INTEGER,		/* integer (casted to/from `code`) */
   CA1_WORD,		/* word value as integer (CODES_PER_WORD) */
   CA1_FLOAT,		/* next CODES_PER_DOUBLE are double */
@@ -1574,7 +1615,8 @@ typedef enum vm_arg_type
 
 typedef enum
 { VMI_REPLACE,
-  VMI_STEP_ARGUMENT
+  VMI_STEP_ARGUMENT,
+  VMI_FUSE
 } vmi_merge_type;
 
 typedef struct
@@ -1665,6 +1707,8 @@ struct clause_index
   iarg_t	 args[MAX_MULTI_INDEX];	/* Indexed arguments */
   iarg_t	 position[MAXINDEXDEPTH+1]; /* Deep index position */
   float		 speedup;		/* Estimated speedup */
+  struct bloom_filter *bloom;		/* Bloom filter on multi-arg keys */
+  struct perfect_hash *perfect;		/* Perfect hash for the buckets */
   ClauseBucket	 entries;		/* chains holding the clauses */
 };
 
@@ -1673,6 +1717,9 @@ struct clause_index
 typedef struct local_definitions
 { Definition *blocks[MAX_BLOCKS];
   Definition preallocated[7];
+  Definition shared;			/* Empty definition for callers */
+  struct hash_hints *index_hints;	/* Indexes created by threads */
+  int		index_hint_count;	/* # index_hints */
 } local_definitions;
 
 struct definition
@@ -1687,6 +1734,7 @@ struct definition
   } impl;
   uint64_t	flags;			/* booleans (P_*) */
   unsigned int  shared;			/* #procedures sharing this def */
+  unsigned int  hot_count;		/* I_ENTER count for O_QUICKEN */
   Module	module;			/* module of the predicate */
   struct linger_list  *lingering;	/* Assocated lingering objects */
   gen_t		last_modified;		/* Generation I was last modified */
@@ -2136,6 +2184,8 @@ typedef struct module_enum
 			   } while(0)
 #define DiscardMark(b)	do { LD->mark_bar = (LD->frozen_bar > (b).saved_bar.as_ptr ? \
 					     LD->frozen_bar : (b).saved_bar.as_ptr); \
+			     if ( LD->young_bar > LD->mark_bar ) \
+			       LD->mark_bar = LD->young_bar; \
 			     DEBUG(CHK_SECURE, \
 				   assert(LD->mark_bar == NO_MARK_BAR || \
 					  (LD->mark_bar >= gBase && \
@@ -2796,7 +2846,9 @@ typedef enum plflag
   PLFLAG_OPTIMISE_UNIFY,		/* Move unifications in clauses */
   PLFLAG_SHIFT_CHECK,			/* Check suspicious shifts */
   PLFLAG_AGC_CLOSE_STREAMS,		/* AGC may close open streams */
-  PLFLAG_EPILOG				/* swipl-win */
+  PLFLAG_EPILOG,			/* swipl-win */
+  PLFLAG_SHARED_THREAD_LOCAL,		/* Share unmodified thread-local defs */
+  PLFLAG_GC_GENERATIONAL		/* Collect the young generation */
 } plflag;
 
 typedef struct
@@ -42,6 +42,8 @@
 #include "os/pl-prologflag.h"
 #include "pl-fli.h"
 #include "pl-wam.h"
+#include "pl-prims.h"
+#include "pl-dbref.h"
 #include <math.h>
 
 #undef LD
@@ -73,6 +75,17 @@
     Create an index if there are more than this number of clauses
   - MIN_SPEEDUP_RATIO
     Need at least this ratio of #clauses/speedup for creating an index
+  - FILL_THREADS
+    Max number of threads used to fill a new index
+  - FILL_MIN_CLAUSES
+    Use multiple threads to fill an index if the predicate has at least
+    this number of clauses.
+  - BLOOM_BITS
+    Number of bits per bucket for the Bloom filter of a multi-argument
+    index.  0 disables Bloom filters.
+  - SAMPLE_RATE
+    If > 0, record one in this number of calls that scan the clause
+    list or use a poor index.  See INDEX ADVICE.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 #define MIN_SPEEDUP           (GD->clause_index.min_speedup)
@@ -80,6 +93,10 @@
 #define MIN_SPEEDUP_RATIO     (GD->clause_index.min_speedup_ratio)
 #define MAX_LOOKAHEAD         (GD->clause_index.max_lookahead)
 #define MIN_CLAUSES_FOR_INDEX (GD->clause_index.min_clauses)
+#define FILL_THREADS	      (GD->clause_index.fill_threads)
+#define FILL_MIN_CLAUSES      (GD->clause_index.fill_min_clauses)
+#define BLOOM_BITS	      (GD->clause_index.bloom_bits)
+#define SAMPLE_RATE	      (GD->clause_index.sample)
 
 
 		 /*******************************
@@ -90,13 +107,6 @@ static const struct clause_index dead_index = {};
 #define DEAD_INDEX   ((ClauseIndex)(&dead_index))
 #define ISDEADCI(ci) ((ci) == DEAD_INDEX)
 
-typedef struct hash_hints
-{ float		speedup;		/* Expected speedup */
-  unsigned	list : 1;		/* Use a list per key */
-  unsigned	ln_buckets : 5;		/* Lg2 of #buckets to use */
-  iarg_t	args[MAX_MULTI_INDEX];	/* Hash these arguments */
-} hash_hints;
-
 typedef struct index_context
 { gen_t		generation;		/* Current generation */
   Definition	predicate;		/* Current predicate */
@@ -115,6 +125,8 @@ typedef struct index_context
 #define find_multi_argument_hash(ac, clist, inst, ninst, bthan, hints, ctx) \
 	LDFUNC(find_multi_argument_hash, ac, clist, inst, ninst, \
 	       bthan, hints, ctx)
+#define shareLocalIndex(local, hints) \
+	LDFUNC(shareLocalIndex, local, hints)
 #endif /*USE_LD_MACROS*/
 
 #define LDFUNC_DECLARATIONS
@@ -130,9 +142,17 @@ static void	deleteIndexP(Definition def, ClauseList cl, ClauseIndex *cip);
 static void	deleteIndex(Definition def, ClauseList cl, ClauseIndex ci);
 static void	insertIndex(Definition def, ClauseList clist, ClauseIndex ci);
 static void	setClauseChoice(ClauseRef cref, const IndexContext ctx);
-static bool	addClauseToIndex(ClauseIndex ci, Clause cl, ClauseRef where);
+static bool	addClauseToIndex(ClauseIndex ci, Clause cl, ClauseRef where,
+				 prepared_key *pk);
+static bool	indexKeysFromClause(ClauseIndex ci, Clause cl,
+				    word *keyp, word *arg1keyp);
+static unsigned int addKeyedClauseToIndex(ClauseIndex ci, Clause cl,
+				    word key, word arg1key, ClauseRef where,
+				    ClauseRef cref,
+				    unsigned int from, unsigned int to);
 static void	addClauseToListIndexes(Definition def, ClauseList cl,
-				       Clause clause, ClauseRef where);
+				       Clause clause, ClauseRef where,
+				       prepared_keys *pk);
 static void	insertIntoSparseList(ClauseRef cref,
 				     ClauseRef *headp, ClauseRef *tailp,
 				     ClauseRef where);
@@ -154,6 +174,9 @@ static bool	find_multi_argument_hash(iarg_t ac, ClauseList clist,
 					 hash_hints *hints, IndexContext ctx);
 static bool	set_candidate_indexes(Definition def, ClauseList clist,
 				      int max, bool lock);
+static void	deleteRangeIndexes(Definition def);
+static size_t	sizeofRangeIndex(RangeIndex ri);
+static void	shareLocalIndex(Definition local, const hash_hints *hints);
 #undef LDFUNC_DECLARATIONS
 
 /* We are reloading static code */
@@ -183,6 +206,59 @@ hashIndex(word key, unsigned int buckets)
   return (fib64*key) >> shift;
 }
 
+/* perfect_key() maps  an index key  to a hash that  does not depend
+ * on  the session,  i.e.,  atoms  and functors  are  hashed on  their
+ * text rather than their handle.  Integer keys and keys for indirect
+ * data (see clean_index_key()) are already independent.
+ */
+
+static inline uint64_t
+perfect_key(word key)
+{ if ( isAtom(key) )
+  { return atomValue(key)->hash_value;
+  } else if ( isFunctor(key) )
+  { FunctorDef fd = valueFunctor(key);
+
+    return ((uint64_t)atomValue(fd->name)->hash_value<<8) ^ fd->arity;
+  }
+
+  return key;
+}
+
+static inline uint64_t
+mix64(uint64_t x)			/* SplitMix64 finalizer */
+{ x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+  return x;
+}
+
+static inline unsigned int
+perfectHashIndex(const perfect_hash *ph, uint64_t h, unsigned int buckets)
+{ uint32_t d = ph->displace[h & (ph->groups-1)];
+
+  return (unsigned int)(mix64(h ^ ((uint64_t)d*0x9E3779B97F4A7C15ULL)) &
+			(buckets-1));
+}
+
+/* Bucket for `key` in `ci`.  If `ci` has a perfect hash, all keys
+ * for which it was computed have their own bucket.  Other keys are
+ * mapped to some bucket, which is fine as buckets may hold multiple
+ * keys.
+ */
+
+static inline unsigned int
+bucketIndex(const ClauseIndex ci, word key)
+{ if ( unlikely(!!ci->perfect) )
+    return perfectHashIndex(ci->perfect,
+			    mix64(perfect_key(key)^ci->perfect->seed),
+			    ci->buckets);
+
+  return hashIndex(key, ci->buckets);
+}
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Compute the index in the hash-array from   a machine word and the number
 of buckets. This used to be simple, but now that our tag bits are on the
@@ -457,6 +533,114 @@ setClauseChoice(DECL_LD ClauseRef cref, const IndexContext ctx)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Multi-argument indexes have a  Bloom  filter   on  the  keys. Most calls
+on such an index are membership tests and  many fail. The Bloom filter
+allows rejecting these calls without  accessing   the  buckets. As a
+clause with a non-indexable key  (key  0)   matches  all  calls,  adding
+such a clause saturates the filter. Clauses are never removed from the
+filter. The filter is sized on  the   number  of  buckets and created
+together with the buckets, such that   no  clause that is added to the
+index can be missed.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct bloom_filter
+{ unsigned int	mask;			/* # bits - 1 */
+  unsigned int	k;			/* # hash functions */
+  bitv_chunk	chunk[];		/* The bits */
+} bloom_filter;
+
+#define SIZEOF_BLOOM(bits) offsetof(bloom_filter, chunk[(bits)/BITSPERE])
+
+static inline uint64_t
+bloom_hash(word key)
+{ uint64_t h = (uint64_t)key * 0x9e3779b97f4a7c15ULL;
+
+  return h ^ (h >> 31);
+}
+
+static bloom_filter *
+newBloomFilter(unsigned int buckets)
+{ size_t want = (size_t)buckets * BLOOM_BITS;
+  size_t nbits = BITSPERE;
+
+  while( nbits < want )
+    nbits <<= 1;
+
+  bloom_filter *bf = allocHeapOrHalt(SIZEOF_BLOOM(nbits));
+  memset(bf, 0, SIZEOF_BLOOM(nbits));
+  bf->mask = (unsigned int)(nbits-1);
+  bf->k    = (BLOOM_BITS*69+50)/100;	/* k = ln(2)*m/n */
+  if ( bf->k < 1 )
+    bf->k = 1;
+  else if ( bf->k > 8 )
+    bf->k = 8;
+
+  return bf;
+}
+
+static inline size_t
+sizeofBloomFilter(const bloom_filter *bf)
+{ return SIZEOF_BLOOM((size_t)bf->mask+1);
+}
+
+static void
+freeBloomFilter(bloom_filter *bf)
+{ freeHeap(bf, sizeofBloomFilter(bf));
+}
+
+static void
+addKeyToBloomFilter(bloom_filter *bf, word key)
+{ if ( key == 0 )
+  { memset(bf->chunk, 0xff, ((size_t)bf->mask+1)/8);
+  } else
+  { uint64_t h = bloom_hash(key);
+    unsigned int h1 = (unsigned int)h;
+    unsigned int h2 = (unsigned int)(h>>32) | 1;
+
+    for(unsigned int i=0; i<bf->k; i++)
+    { unsigned int bit = (h1 + i*h2) & bf->mask;
+      bitv_chunk *cp = &bf->chunk[bit/BITSPERE];
+      bitv_chunk m = (bitv_chunk)1 << (bit%BITSPERE);
+
+      if ( !(*cp & m) )
+	ATOMIC_OR(cp, m);
+    }
+  }
+}
+
+static inline bool
+bloomMayContain(const bloom_filter *bf, word key)
+{ uint64_t h = bloom_hash(key);
+  unsigned int h1 = (unsigned int)h;
+  unsigned int h2 = (unsigned int)(h>>32) | 1;
+
+  for(unsigned int i=0; i<bf->k; i++)
+  { unsigned int bit = (h1 + i*h2) & bf->mask;
+
+    if ( !(bf->chunk[bit/BITSPERE] & ((bitv_chunk)1 << (bit%BITSPERE))) )
+      return false;
+  }
+
+  return true;
+}
+
+/* Estimated false positive rate of the Bloom filter, computed from the
+ * fraction of bits that is set.
+ */
+
+static double
+bloomFalsePositiveRate(const bloom_filter *bf)
+{ size_t nchunks = ((size_t)bf->mask+1)/BITSPERE;
+  size_t set = 0;
+
+  for(size_t i=0; i<nchunks; i++)
+    set += __builtin_popcount(bf->chunk[i]);
+
+  return pow((double)set/((double)bf->mask+1), bf->k);
+}
+
+
 static inline word
 join_multi_arg_keys(const word *key, unsigned int len)
 { word k = MurmurHashAligned2(key, sizeof(word)*len, MURMUR_SEED);
@@ -604,6 +788,17 @@ existing_hash(ClauseIndex *cip, const Word argv, Word keyp)
 
 #define CI_RETRY ((ClauseIndex)1)
 
+/* True if another thread is filling `ci`.  Rather than waiting for the
+ * index to become available we use the plain clause list.  This avoids
+ * stalling all threads that call a large predicate while its index is
+ * being created.
+ */
+
+static inline bool
+being_filled(const ClauseIndex ci)
+{ return ci->incomplete && ci->entries;
+}
+
 #define	createIndex(av, ac, clist, better_than, ctx) \
 	LDFUNC(createIndex, av, ac, clist, better_than, ctx)
 
@@ -616,10 +811,14 @@ createIndex(DECL_LD Word argv, size_t argc, const ClauseList clist,
   { ClauseIndex ci;
 
     if ( (ci=hashDefinition(clist, &hints, ctx)) )
-    { while ( ci->incomplete )
+    { if ( being_filled(ci) )
+	return NULL;			/* use what we have */
+      while ( ci->incomplete )
 	wait_for_index(ci, clist, ctx);
       if ( ci->invalid )
 	return CI_RETRY;
+      if ( ison(ctx->predicate, P_LOCALISED) && ctx->depth == 0 )
+	shareLocalIndex(ctx->predicate, &hints);
 
       return ci;
     }
@@ -630,6 +829,133 @@ createIndex(DECL_LD Word argv, size_t argc, const ClauseList clist,
   return NULL;
 }
 
+		 /*******************************
+		 *	   INDEX ADVICE		*
+		 *******************************/
+
+/* If SAMPLE_RATE is N > 0,  one in N top-level calls that scan the clause
+ * list linearly or use a poor  index is recorded.  For each predicate we
+ * keep a  small number of  call modes, where  a mode is  the bitmask of
+ * instantiated  arguments.   For  each  mode  we keep  the  number  of
+ * calls and the number of clauses  visited.  Both are multiplied by N,
+ * such that  they estimate the totals.   Thread-local predicates are not
+ * sampled  as  their  local   definitions  are  short-lived.   The data
+ * is reported by '$index_advice'/2, which is used by jiti_advice/1 from
+ * library(prolog_jiti).
+ */
+
+#define MAX_ADVICE_MODES 8
+
+typedef struct advice_mode
+{ uint64_t	mask;			/* Instantiated arguments */
+  uint64_t	calls;			/* Estimated # calls */
+  uint64_t	visits;			/* Estimated # visited clauses */
+} advice_mode;
+
+typedef struct index_advice
+{ Definition	predicate;		/* Sampled predicate */
+  advice_mode	modes[MAX_ADVICE_MODES];
+} index_advice;
+
+#define SAMPLE_SCAN(visits) \
+	do \
+	{ if ( unlikely(SAMPLE_RATE > 0) && ctx->depth == 0 ) \
+	    sample_scan(argv, argc, clist, visits, ctx); \
+	} while(0)
+
+/* Return the number of scans to skip  until the next sample.  This is a
+ * random number in 1..2*rate-1, such that we  take on average one in
+ * `rate` samples but avoid aliasing with periodic call patterns.  The
+ * seed is a per-thread xorshift generator.
+ */
+
+#define sample_interval(rate) LDFUNC(sample_interval, rate)
+
+static int
+sample_interval(DECL_LD int rate)
+{ uint32_t x = LD->clause_index.sample_seed;
+
+  if ( !x )
+    x = (uint32_t)(uintptr_t)LD | 1;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  LD->clause_index.sample_seed = x;
+
+  return rate > 1 ? (int)(1 + x%(2*(unsigned)rate-1)) : 1;
+}
+
+#define sample_scan(argv, argc, clist, visits, ctx) \
+	LDFUNC(sample_scan, argv, argc, clist, visits, ctx)
+
+static void
+sample_scan(DECL_LD const Word argv, size_t argc, const ClauseList clist,
+	    size_t visits, const IndexContext ctx)
+{ Definition def = ctx->predicate;
+  int rate = SAMPLE_RATE;
+  uint64_t mask = 0;
+
+  if ( --LD->clause_index.sample_tick > 0 )
+    return;
+  LD->clause_index.sample_tick = sample_interval(rate);
+
+  if ( ison(def, P_THREAD_LOCAL) ||
+       clist->number_of_clauses <= (size_t)MIN_CLAUSES_FOR_INDEX )
+    return;
+
+  for(size_t i=0; i<argc && i<64; i++)
+  { if ( canIndex(argv[i]) )
+      mask |= (uint64_t)1<<i;
+  }
+  if ( !mask )
+    return;
+
+  PL_LOCK(L_MISC);
+  if ( !GD->clause_index.advice )
+    GD->clause_index.advice = newHTableWP(64);
+
+  index_advice *a = lookupHTableWP(GD->clause_index.advice, ptr2key(def));
+  if ( !a )
+  { a = allocHeapOrHalt(sizeof(*a));
+    memset(a, 0, sizeof(*a));
+    a->predicate = def;
+    addNewHTableWP(GD->clause_index.advice, ptr2key(def), a);
+  }
+
+  for(int i=0; i<MAX_ADVICE_MODES; i++)
+  { advice_mode *m = &a->modes[i];
+
+    if ( m->mask == mask || !m->mask )
+    { m->mask    = mask;
+      m->calls  += rate;
+      m->visits += (uint64_t)visits*rate;
+      break;
+    }
+  }
+  PL_UNLOCK(L_MISC);
+}
+
+
+/* Called from unallocDefinition() to remove advice on a predicate that
+ * is being deleted.
+ */
+
+void
+forgetIndexAdvice(Definition def)
+{ GET_LD
+
+  if ( GD->clause_index.advice )
+  { index_advice *a;
+
+    PL_LOCK(L_MISC);
+    a = deleteHTableWP(GD->clause_index.advice, ptr2key(def));
+    PL_UNLOCK(L_MISC);
+    if ( a )
+      freeHeap(a, sizeof(*a));
+  }
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 firstClause() finds the first applicable   clause  and leave information
 for finding the next clause in chp.
@@ -651,7 +977,8 @@ first_clause_guarded(DECL_LD const Word argv, size_t argc, ClauseList clist,
   /* If `clist->unindexed`, no primary index is possible. */
 
   if ( clist->unindexed || argc == 0 )
-  { chp->cref = clist->first_clause;
+  { SAMPLE_SCAN(clist->number_of_clauses);
+    chp->cref = clist->first_clause;
     return next_clause_unindexed(ctx);
   }
 
@@ -686,12 +1013,28 @@ retry:
 	}
 
 	if ( best_index->incomplete )
-	{ wait_for_index(best_index, clist, ctx);
+	{ if ( being_filled(best_index) )
+	  { chp->key = indexOfWord(argv[clist->primary_index]);
+	    chp->cref = clist->first_clause;
+	    if ( chp->key )
+	      return next_clause_primary_index(ctx);
+	    else
+	      return next_clause_unindexed(ctx);
+	  }
+	  wait_for_index(best_index, clist, ctx);
 	  goto retry;
 	}
+
+	if ( !best_index->good && best_index->speedup > 1.0 )
+	  SAMPLE_SCAN((size_t)((float)clist->number_of_clauses/
+			       best_index->speedup));
       }
 
-      unsigned int hi = hashIndex(chp->key, best_index->buckets);
+      if ( best_index->bloom &&
+	   !bloomMayContain(best_index->bloom, chp->key) )
+	return NULL;
+
+      unsigned int hi = bucketIndex(best_index, chp->key);
       const ClauseBucket bkt = &best_index->entries[hi];
       if ( bkt->key && chp->key != bkt->key )
 	return NULL;
@@ -704,7 +1047,8 @@ retry:
   chp->key = indexOfWord(argv[pindex]);
 
   if ( clist->fixed_indexes )	/* set_candidate_indexes() has been run */
-  { chp->cref = clist->first_clause;
+  { SAMPLE_SCAN(clist->number_of_clauses);
+    chp->cref = clist->first_clause;
     if ( chp->key )
       return next_clause_primary_index(ctx);
     else
@@ -751,7 +1095,7 @@ retry:
 
       chp->key = indexKeyFromArgv(ci, argv);
       assert(chp->key);
-      unsigned int hi = hashIndex(chp->key, ci->buckets);
+      unsigned int hi = bucketIndex(ci, chp->key);
       chp->cref = ci->entries[hi].head;
       return nextClauseFromBucket(ci, argv, ctx);
     }
@@ -760,6 +1104,7 @@ retry:
   if ( cref )			/* from next_clause_primary_index() call */
     return cref;
 
+  SAMPLE_SCAN(clist->number_of_clauses);
   chp->cref = clist->first_clause;
   if ( chp->key )
     return next_clause_primary_index(ctx);
@@ -798,6 +1143,17 @@ firstClause(DECL_LD Word argv, LocalFrame fr, Definition def,
 }
 
 
+#define next_clause(ctx) LDFUNC(next_clause, ctx)
+
+static inline ClauseRef
+next_clause(DECL_LD const IndexContext ctx)
+{ if ( !ctx->chp->key )			/* not indexed */
+    return next_clause_unindexed(ctx);
+  else
+    return next_clause_primary_index(ctx);
+}
+
+
 ClauseRef
 nextClause(DECL_LD const ClauseChoice chp, const Word argv,
 	   const LocalFrame fr, const Definition def)
@@ -812,11 +1168,7 @@ nextClause(DECL_LD const ClauseChoice chp, const Word argv,
   ctx.predicate = def;
   ctx.generation = generationFrame(fr);
 
-  if ( !chp->key )			/* not indexed */
-  { cref = next_clause_unindexed(&ctx);
-  } else
-  { cref = next_clause_primary_index(&ctx);
-  }
+  cref = next_clause(&ctx);
   release_def(def);
 
   DEBUG(CHK_SECURE,
@@ -827,6 +1179,68 @@ nextClause(DECL_LD const ClauseChoice chp, const Word argv,
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+skipGuardedClauses() implements guard indexing.  It is called by the VM
+after firstClause() or nextClause() if the selected clause or the next
+candidate is flagged CL_GUARD (see guardedCandidates()).  It skips the
+selected clause and the next candidates as long as clauseGuardFails().
+If no candidate remains, chp->cref is cleared and the VM does not need
+to create a choicepoint.
+
+This is only used for executing the predicate.  clause/2, retract/1,
+etc. must see all clauses.  We also do not skip clauses if we are
+debugging, so the tracer shows the guard failing.  Neither do we skip
+clauses if there are attributed variables, because head unification of
+the skipped clause may wake up goals that have side effects or raise an
+exception.  For the same reason we do not skip clauses if the flag
+occurs_check is not `false`: head unification may raise an occurs_check
+error.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+ClauseRef
+skipGuardedClauses(DECL_LD ClauseRef cref, const Word argv,
+		   const LocalFrame fr, const Definition def,
+		   const ClauseChoice chp)
+{ if ( debugstatus.debugging || !truePrologFlag(PLFLAG_VMI_BUILTIN) ||
+       LD->attvar.attvars ||
+       LD->prolog_flag.occurs_check != OCCURS_CHECK_FALSE )
+    return cref;
+
+  MEMORY_ACQUIRE();
+  acquire_def(def);
+  index_context ctx;
+  ctx.chp = chp;
+  ctx.predicate = def;
+  ctx.generation = generationFrame(fr);
+
+  while ( cref && ison(cref->value.clause, CL_GUARD) &&
+	  clauseGuardFails(cref->value.clause, argv) )
+  { if ( chp->cref )
+    { cref = next_clause(&ctx);
+    } else
+      cref = NULL;
+  }
+
+  if ( cref )
+  { while ( chp->cref && ison(chp->cref->value.clause, CL_GUARD) )
+    { struct clause_choice alt = *chp;
+      ClauseRef next;
+
+      ctx.chp = &alt;
+      next = next_clause(&ctx);
+      if ( next && !clauseGuardFails(next->value.clause, argv) )
+	break;
+      *chp = alt;
+      if ( !next )
+	chp->cref = NULL;
+    }
+  }
+  release_def(def);
+
+  return cref;
+}
+
+
 		 /*******************************
 		 *	   HASH SUPPORT		*
 		 *******************************/
@@ -872,9 +1286,19 @@ realize_clause_index(ClauseIndex ci)
 { size_t bytes = sizeof(struct clause_bucket) * ci->buckets;
   ClauseBucket buckets = allocHeapOrHalt(bytes);
   memset(buckets, 0, bytes);
-  bool rc = COMPARE_AND_SWAP_PTR(&ci->entries, NULL, buckets);
+  bool rc;
+
+  if ( ci->args[1] && BLOOM_BITS > 0 && !ci->bloom )
+  { bloom_filter *bf = newBloomFilter(ci->buckets);
+
+    if ( !COMPARE_AND_SWAP_PTR(&ci->bloom, NULL, bf) )
+      freeBloomFilter(bf);
+  }
+  rc = COMPARE_AND_SWAP_PTR(&ci->entries, NULL, buckets);
   if ( rc )
     ATOMIC_INC(&GD->statistics.indexes.created);
+  else
+    freeHeap(buckets, bytes);
   return rc;
 }
 
@@ -957,6 +1381,10 @@ unallocClauseIndexTable(ClauseIndex ci)
   { unallocClauseIndexTableEntries(ci);
     ATOMIC_INC(&GD->statistics.indexes.destroyed);
   }
+  if ( ci->bloom )
+    freeBloomFilter(ci->bloom);
+  if ( ci->perfect )
+    freePerfectHash(ci->perfect);
   freeHeap(ci, sizeof(struct clause_index));
 }
 
@@ -994,13 +1422,30 @@ addToClauseList(ClauseRef cref, Clause clause, word key, ClauseRef where)
     cl->number_of_clauses = 1;
   }
 
-  addClauseToListIndexes(def, cl, clause, where);
+  addClauseToListIndexes(def, cl, clause, where, NULL);
+}
+
+
+static prepared_key *
+findPreparedKey(prepared_keys *pk, const ClauseIndex ci)
+{ if ( pk )
+  { for(int i=0; i<pk->count; i++)
+    { prepared_key *k = &pk->keys[i];
+
+      if ( k->ci == ci &&
+	   k->is_list == ci->is_list &&
+	   memcmp(k->args, ci->args, sizeof(k->args)) == 0 )
+	return k;
+    }
+  }
+
+  return NULL;
 }
 
 
 static void
 addClauseToListIndexes(Definition def, ClauseList cl, Clause clause,
-		       ClauseRef where)
+		       ClauseRef where, prepared_keys *pk)
 { ClauseIndex *cip;
 
   if ( (cip=cl->clause_indexes) )
@@ -1016,7 +1461,7 @@ addClauseToListIndexes(Definition def, ClauseList cl, Clause clause,
 	continue;
 
       if ( ci->size >= ci->resize_above ||
-	   !addClauseToIndex(ci, clause, where) )
+	   !addClauseToIndex(ci, clause, where, findPreparedKey(pk, ci)) )
 	deleteIndexP(def, cl, cip);
     }
   }
@@ -1091,13 +1536,17 @@ Where is one of
   - CL_END   (assertz)
   - The clause reference before which the clause must be inserted.
     This is used by reconsult.
+
+If `cr` is not NULL, it is a clause reference for `cl` and `key` that was
+allocated before the predicate was locked.  It is only used for plain
+(non-list) buckets.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 static int
 addClauseBucket(ClauseBucket ch, Clause cl,
-		word key, word arg1key, ClauseRef where, int is_list)
-{ ClauseRef cr;
-
+		word key, word arg1key, ClauseRef where, int is_list,
+		ClauseRef cr)
+{
   if ( is_list )
   { ClauseRef cref;
     ClauseList vars = NULL;
@@ -1140,7 +1589,8 @@ addClauseBucket(ClauseBucket ch, Clause cl,
     }
     addToClauseList(cr, cl, arg1key, where);
   } else
-  { cr = newClauseRef(cl, key);
+  { if ( !cr )
+      cr = newClauseRef(cl, key);
     if ( !ch->head )
       ch->key = key;
     else if ( ch->key != key )
@@ -1567,7 +2017,7 @@ indexKeyFromClause(ClauseIndex ci, Clause cl, Code *end)
       PC = skipArgs(PC, arg, &h_void);
     if ( end )
       *end = PC;
-    if ( argKey(PC, 0, &key) )
+    if ( argKeyAt(PC, h_void, &key) )
       return key;
     return 0;
   } else
@@ -1581,7 +2031,7 @@ indexKeyFromClause(ClauseIndex ci, Clause cl, Code *end)
     { if ( ci->args[harg] > pcarg )
 	PC = skipArgs(PC, ci->args[harg]-pcarg, &h_void);
       pcarg = ci->args[harg];
-      if ( !argKey(PC, 0, &key[harg]) )
+      if ( !argKeyAt(PC, h_void, &key[harg]) )
 	return 0;
     }
 
@@ -1621,7 +2071,7 @@ deleteActiveClauseFromIndex(ClauseIndex ci, Clause cl)
     }
     assert(ci->dirty == ci->buckets);
   } else
-  { int hi = hashIndex(key, ci->buckets);
+  { int hi = bucketIndex(ci, key);
     ClauseBucket cb = &ci->entries[hi];
 
     if ( cb->dirty == 0 )
@@ -1746,6 +2196,7 @@ deleteIndexesDefinition(Definition def)
 
     freeHeap(cip0, 0);
   }
+  deleteRangeIndexes(def);
 }
 
 
@@ -1761,15 +2212,43 @@ TBD: Merge compound detection with skipToTerm()
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 static bool
-addClauseToIndex(ClauseIndex ci, Clause cl, ClauseRef where)
-{ Code pc = NULL;
-  ClauseBucket ch = ci->entries;
-  word arg1key = 0;
+addClauseToIndex(ClauseIndex ci, Clause cl, ClauseRef where,
+		 prepared_key *pk)
+{ word key, arg1key;
+  ClauseRef cref = NULL;
 
-  if ( !ch )
+  if ( !ci->entries )
     return true;
 
+  if ( pk )
+  { if ( !pk->ok )
+      return false;
+    key      = pk->key;
+    arg1key  = pk->arg1key;
+    cref     = pk->cref;
+    pk->cref = NULL;
+  } else if ( !indexKeysFromClause(ci, cl, &key, &arg1key) )
+    return false;
+  if ( ci->bloom )
+    addKeyToBloomFilter(ci->bloom, key);
+  ci->size += addKeyedClauseToIndex(ci, cl, key, arg1key, where, cref,
+				    0, ci->buckets);
+
+  return true;
+}
+
+
+/* Compute the key of `cl` for `ci`.  For list indexes we also need the
+ * key  of the  first argument  of the  compound.  Returns  `false` if
+ * the clause cannot be added to a list index.
+ */
+
+static bool
+indexKeysFromClause(ClauseIndex ci, Clause cl, word *keyp, word *arg1keyp)
+{ Code pc = NULL;
   word key = indexKeyFromClause(ci, cl, &pc);
+
+  *arg1keyp = 0;
   if ( ci->is_list )			/* find first argument key for term */
   { if ( key == 0 )
       return false;
@@ -1779,34 +2258,106 @@ addClauseToIndex(ClauseIndex ci, Clause cl, ClauseRef where)
       case H_RFUNCTOR:
       case H_RLIST:
 	pc = stepPC(pc);
-	argKey(pc, 0, &arg1key);
+	argKey(pc, 0, arg1keyp);
     }
   }
+  *keyp = key;
 
-  if ( key == 0 )			/* a non-indexable field */
-  { int n = ci->buckets;
+  return true;
+}
+
+
+/* Add a clause with known keys to the buckets `from` ... `to-1` of `ci`.
+ * Restricting the range allows for  filling the buckets of an index from
+ * multiple threads.  Returns the number of indexable entries added.
+ * `cref` is an optional pre-allocated reference.  It is only passed for
+ * an indexable key in a plain index over all buckets, so it is always
+ * used.
+ */
+
+static unsigned int
+addKeyedClauseToIndex(ClauseIndex ci, Clause cl, word key, word arg1key,
+		      ClauseRef where, ClauseRef cref,
+		      unsigned int from, unsigned int to)
+{ ClauseBucket ch = ci->entries;
 
-    for(; n; n--, ch++)
-      addClauseBucket(ch, cl, key, arg1key, where, ci->is_list);
+  if ( key == 0 )			/* a non-indexable field */
+  { for(unsigned int i=from; i<to; i++)
+      addClauseBucket(&ch[i], cl, key, arg1key, where, ci->is_list, NULL);
   } else
-  { unsigned int hi = hashIndex(key, ci->buckets);
+  { unsigned int hi = bucketIndex(ci, key);
 
-    DEBUG(MSG_INDEX_UPDATE, Sdprintf("Storing in bucket %d\n", hi));
-    ci->size += addClauseBucket(&ch[hi], cl, key, arg1key, where, ci->is_list);
+    if ( hi >= from && hi < to )
+    { DEBUG(MSG_INDEX_UPDATE, Sdprintf("Storing in bucket %d\n", hi));
+      return addClauseBucket(&ch[hi], cl, key, arg1key, where, ci->is_list,
+			     cref);
+    }
   }
 
-  return true;
+  return 0;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+prepareClauseIndexKeys() computes the keys of a new clause for the
+existing indexes of a predicate and allocates the clause references for
+plain hash buckets.  It is called by assertDefinition() *before* the
+predicate is locked, such that concurrent writers only hold the lock
+while linking the clause.  Indexes are identified by their address and
+arguments.  If the index set changes before we lock, non-matching entries
+are not used and the key is computed under the lock as before.
+releasePreparedKeys() must be called after the predicate is unlocked to
+discard unused references.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+void
+prepareClauseIndexKeys(DECL_LD Definition def, Clause cl, prepared_keys *pk)
+{ ClauseIndex *cip;
+
+  pk->count = 0;
+  acquire_def(def);
+  if ( (cip=def->impl.clauses.clause_indexes) )
+  { for(; *cip && pk->count < MAX_PREPARED_KEYS; cip++)
+    { ClauseIndex ci = *cip;
+      prepared_key *k;
+
+      if ( ISDEADCI(ci) || !ci->entries )
+	continue;
+
+      k = &pk->keys[pk->count++];
+      k->ci      = ci;
+      k->is_list = ci->is_list;
+      k->cref    = NULL;
+      memcpy(k->args, ci->args, sizeof(k->args));
+      k->ok = indexKeysFromClause(ci, cl, &k->key, &k->arg1key);
+      if ( k->ok && k->key && !k->is_list )
+	k->cref = newClauseRef(cl, k->key);
+    }
+  }
+  release_def(def);
+}
+
+
+void
+releasePreparedKeys(prepared_keys *pk)
+{ for(int i=0; i<pk->count; i++)
+  { if ( pk->keys[i].cref )
+      freeClauseRef(pk->keys[i].cref);
+  }
+  pk->count = 0;
 }
 
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 addClauseToIndexes() is called (only) by   assertProcedure(),  which has
-the definition locked.
+the definition locked.  `pk` holds the keys computed by
+prepareClauseIndexKeys() or is NULL.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 int
-addClauseToIndexes(Definition def, Clause clause, ClauseRef where)
-{ addClauseToListIndexes(def, &def->impl.clauses, clause, where);
+addClauseToIndexes(Definition def, Clause clause, ClauseRef where,
+		   prepared_keys *pk)
+{ addClauseToListIndexes(def, &def->impl.clauses, clause, where, pk);
   reconsider_index(def);
 
   DEBUG(CHK_SECURE, checkDefinition(def));
@@ -1843,7 +2394,7 @@ delClauseFromIndex(Definition def, Clause cl)
       for(; n; n--, ch++)
 	deleteClauseBucket(ch, cl, key, ci->is_list);
     } else
-    { int hi = hashIndex(key, ci->buckets);
+    { int hi = bucketIndex(ci, key);
 
       ci->size -= deleteClauseBucket(&ch[hi], cl, key, ci->is_list);
     }
@@ -1896,54 +2447,323 @@ completed_index(ClauseIndex ci)
 
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-Create a hash-index on def  for  arg.   We  compute  the  hash unlocked,
-checking at the end that nobody  messed   with  the clause list. If that
-happened anyway, we retry. At the end,   we  lock the definition and add
-the new index to the indexes of the predicate.
+Fill the buckets of a  large index using multiple threads.  This is done
+in two steps:
+
+  1. Collect the live clauses in an array and compute the keys for
+     slices of this array in parallel.
+  2. Give each thread a range of buckets.  The clauses are distributed
+     in clause order over the threads whose range holds their bucket.
+     Clauses with a non-indexable key are added to all buckets and thus
+     given to all threads.  Each thread adds its clauses.  As threads
+     never touch the same bucket, this needs no locking and preserves
+     the clause order inside each bucket.
+
+The calling thread takes the first job  of each step.  If we cannot get
+enough resources we return -1 and the caller falls back to the
+sequential fill.
+
+The helper threads are  counted  in  GD->clause_index.fill_workers.  All
+concurrent fills together use at  most ci_fill_threads-1 helpers.  A fill
+takes the helpers that are free and  is done sequentially if there are
+none, so N threads filling indexes at  the same time do not create N
+times ci_fill_threads OS threads.
+
+@return true if the index was filled, false if a clause cannot be
+added to a list index, -1 if the parallel fill was not used.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-static ClauseIndex
-fill_clause_index(ClauseIndex ci, ClauseList clist, IndexContext ctx)
-{ for(ClauseRef cref = clist->first_clause; cref; cref = cref->next)
-  { if ( isoff(cref->value.clause, CL_ERASED) )
-    { if ( !addClauseToIndex(ci, cref->value.clause, CL_END) )
-      { ci->invalid = true;
-	completed_index(ci);
-	deleteIndex(ctx->predicate, clist, ci);
-	return NULL;
-      }
+#ifdef O_PLMT
+
+typedef struct fill_entry
+{ Clause	clause;			/* The clause to add */
+  word		key;			/* Its key for the index */
+  word		arg1key;		/* Key of 1st arg (list index) */
+} fill_entry;
+
+typedef struct fill_job
+{ ClauseIndex	ci;			/* Index we are filling */
+  fill_entry   *entries;		/* Clauses to add */
+  size_t	from;			/* Step 1: first entry */
+  size_t	to;			/* Step 1: last entry (excl) */
+  fill_entry  **order;			/* Step 2: entries for our buckets */
+  size_t	count;			/* Step 2: # entries */
+  unsigned int	bfrom;			/* Step 2: first bucket */
+  unsigned int	bto;			/* Step 2: last bucket (excl) */
+  unsigned int	size;			/* Step 2: indexable entries added */
+  bool		ok;			/* Step 1: all keys are valid */
+  pthread_t	thread;			/* Thread running the job */
+  bool		started;		/* Thread was started */
+} fill_job;
+
+static void *
+fill_keys_worker(void *closure)
+{ fill_job *job = closure;
+
+  job->ok = true;
+  for(size_t i=job->from; i<job->to; i++)
+  { fill_entry *e = &job->entries[i];
+
+    if ( !indexKeysFromClause(job->ci, e->clause, &e->key, &e->arg1key) )
+    { job->ok = false;
+      break;
     }
+    if ( job->ci->bloom )
+      addKeyToBloomFilter(job->ci->bloom, e->key);
   }
 
-  ci->resize_above = ci->size*2;
-  ci->resize_below = ci->size/4;
-
-  completed_index(ci);
-  if ( !consider_better_index(ci->speedup, clist->number_of_clauses) )
-    ci->good = true;		/* `good` means complete and sufficient */
-
-  return ci;
+  return NULL;
 }
 
+static void *
+fill_buckets_worker(void *closure)
+{ fill_job *job = closure;
 
-static ClauseIndex
-hashDefinition(ClauseList clist, hash_hints *hints, IndexContext ctx)
-{ ClauseIndex ci;
-  ClauseIndex *cip;
+  job->size = 0;
+  for(size_t i=0; i<job->count; i++)
+  { fill_entry *e = job->order[i];
 
-  DEBUG(MSG_JIT, Sdprintf("[%d] hashDefinition(%s, %s, %d) (%s)\n",
-			  PL_thread_self(),
-			  predicateName(ctx->predicate),
-			  iargsName(hints->args, NULL), 2<<hints->ln_buckets,
-			  hints->list ? "lists" : "clauses"));
+    job->size += addKeyedClauseToIndex(job->ci, e->clause,
+				       e->key, e->arg1key, CL_END, NULL,
+				       job->bfrom, job->bto);
+  }
 
-#if defined(O_PLMT) && defined(O_DEBUG)
-{ GET_LD
-  assert(LD->thread.info->access.predicate == ctx->predicate);
+  return NULL;
 }
-#endif
 
-  canonicalHap(hints->args);
+/* Run the jobs, one per thread.  If a thread cannot be created we do
+ * not try to create more.  The jobs without a thread are run by the
+ * calling thread, so the result is the same.
+ */
+
+static void
+run_fill_jobs(fill_job *jobs, int njobs, void *(*func)(void*))
+{ int i;
+
+  for(i=1; i<njobs; i++)
+  { jobs[i].started = pthread_create(&jobs[i].thread, NULL,
+				     func, &jobs[i]) == 0;
+    if ( !jobs[i].started )
+    { DEBUG(MSG_JIT, Sdprintf("[%d] could not create fill thread %d\n",
+			      PL_thread_self(), i));
+      for(i++; i<njobs; i++)
+	jobs[i].started = false;
+      break;
+    }
+  }
+  (*func)(&jobs[0]);
+  for(i=1; i<njobs; i++)
+  { if ( jobs[i].started )
+      pthread_join(jobs[i].thread, NULL);
+    else
+      (*func)(&jobs[i]);
+  }
+}
+
+/* Reserve at most `n` helper threads for filling an index.  Returns the
+ * number reserved, which may be 0.
+ */
+
+static int
+reserve_fill_workers(int n)
+{ for(;;)
+  { int active = GD->clause_index.fill_workers;
+    int avail  = FILL_THREADS - 1 - active;
+    int got    = n < avail ? n : avail;
+
+    if ( got <= 0 )
+      return 0;
+    if ( COMPARE_AND_SWAP_INT(&GD->clause_index.fill_workers,
+			      active, active+got) )
+      return got;
+  }
+}
+
+static void
+release_fill_workers(int n)
+{ if ( n > 0 )
+    ATOMIC_SUB(&GD->clause_index.fill_workers, n);
+}
+
+/* The job whose bucket range holds `key`.  Job i fills the buckets
+ * buckets*i/nthreads ... buckets*(i+1)/nthreads.
+ */
+
+static int
+fill_job_of_key(ClauseIndex ci, word key, int nthreads)
+{ size_t hi = bucketIndex(ci, key);
+
+  return (int)(((hi+1)*nthreads - 1)/ci->buckets);
+}
+
+static int
+fill_clause_index_parallel(ClauseIndex ci, ClauseList clist)
+{ int nthreads = FILL_THREADS;
+  int nhelpers;
+  tmp_buffer buf;
+  fill_job *jobs;
+  fill_entry *entries;
+  fill_entry **order = NULL;
+  size_t count, nvar = 0;
+  int rc = true;
+
+  if ( nthreads < 2 ||
+       clist->number_of_clauses < (unsigned int)FILL_MIN_CLAUSES ||
+       FILL_MIN_CLAUSES <= 0 )
+    return -1;
+  if ( (unsigned int)nthreads > ci->buckets )
+    nthreads = ci->buckets;
+  if ( (nhelpers = reserve_fill_workers(nthreads-1)) == 0 )
+    return -1;
+  nthreads = nhelpers+1;
+  if ( !(jobs = malloc(nthreads*sizeof(*jobs))) )
+  { release_fill_workers(nhelpers);
+    return -1;
+  }
+  memset(jobs, 0, nthreads*sizeof(*jobs));
+
+  initBuffer(&buf);
+  for(ClauseRef cref = clist->first_clause; cref; cref = cref->next)
+  { if ( isoff(cref->value.clause, CL_ERASED) )
+    { fill_entry e = { .clause = cref->value.clause };
+      addBuffer(&buf, e, fill_entry);
+    }
+  }
+  entries = baseBuffer(&buf, fill_entry);
+  count = entriesBuffer(&buf, fill_entry);
+
+  DEBUG(MSG_JIT, Sdprintf("[%d] filling index %s using %d threads "
+			  "(%zd clauses)\n",
+			  PL_thread_self(), iargsName(ci->args, NULL),
+			  nthreads, count));
+
+  for(int i=0; i<nthreads; i++)		/* Step 1: compute keys */
+  { jobs[i].ci      = ci;
+    jobs[i].entries = entries;
+    jobs[i].from    = count*i/nthreads;
+    jobs[i].to      = count*(i+1)/nthreads;
+  }
+  run_fill_jobs(jobs, nthreads, fill_keys_worker);
+  for(int i=0; i<nthreads; i++)
+  { if ( !jobs[i].ok )
+    { rc = false;
+      goto out;
+    }
+  }
+
+  for(int i=0; i<nthreads; i++)		/* Step 2: fill buckets */
+  { jobs[i].count = 0;
+    jobs[i].bfrom = (unsigned int)((size_t)ci->buckets*i/nthreads);
+    jobs[i].bto   = (unsigned int)((size_t)ci->buckets*(i+1)/nthreads);
+  }
+  for(size_t i=0; i<count; i++)
+  { if ( entries[i].key )
+      jobs[fill_job_of_key(ci, entries[i].key, nthreads)].count++;
+    else
+      nvar++;
+  }
+  if ( !(order = malloc((count-nvar+nvar*nthreads)*sizeof(*order))) )
+  { rc = -1;
+    goto out;
+  }
+  fill_entry **op = order;
+  for(int i=0; i<nthreads; i++)
+  { jobs[i].order = op;
+    op += jobs[i].count + nvar;
+    jobs[i].count = 0;
+  }
+  for(size_t i=0; i<count; i++)
+  { fill_entry *e = &entries[i];
+
+    if ( e->key )
+    { fill_job *job = &jobs[fill_job_of_key(ci, e->key, nthreads)];
+
+      job->order[job->count++] = e;
+    } else
+    { for(int j=0; j<nthreads; j++)
+	jobs[j].order[jobs[j].count++] = e;
+    }
+  }
+  run_fill_jobs(jobs, nthreads, fill_buckets_worker);
+  for(int i=0; i<nthreads; i++)
+    ci->size += jobs[i].size;
+
+out:
+  discardBuffer(&buf);
+  free(order);
+  free(jobs);
+  release_fill_workers(nhelpers);
+
+  return rc;
+}
+
+#endif /*O_PLMT*/
+
+static bool
+fill_clause_index_sequential(ClauseIndex ci, ClauseList clist)
+{ for(ClauseRef cref = clist->first_clause; cref; cref = cref->next)
+  { if ( isoff(cref->value.clause, CL_ERASED) )
+    { if ( !addClauseToIndex(ci, cref->value.clause, CL_END, NULL) )
+	return false;
+    }
+  }
+
+  return true;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Create a hash-index on def  for  arg.   We  compute  the  hash unlocked,
+checking at the end that nobody  messed   with  the clause list. If that
+happened anyway, we retry. At the end,   we  lock the definition and add
+the new index to the indexes of the predicate.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static ClauseIndex
+fill_clause_index(ClauseIndex ci, ClauseList clist, IndexContext ctx)
+{ int rc = -1;
+
+#ifdef O_PLMT
+  rc = fill_clause_index_parallel(ci, clist);
+#endif
+  if ( rc == -1 )
+    rc = fill_clause_index_sequential(ci, clist);
+
+  if ( !rc )
+  { ci->invalid = true;
+    completed_index(ci);
+    deleteIndex(ctx->predicate, clist, ci);
+    return NULL;
+  }
+
+  ci->resize_above = ci->size*2;
+  ci->resize_below = ci->size/4;
+
+  completed_index(ci);
+  if ( !consider_better_index(ci->speedup, clist->number_of_clauses) )
+    ci->good = true;		/* `good` means complete and sufficient */
+
+  return ci;
+}
+
+
+static ClauseIndex
+hashDefinition(ClauseList clist, hash_hints *hints, IndexContext ctx)
+{ ClauseIndex ci;
+  ClauseIndex *cip;
+
+  DEBUG(MSG_JIT, Sdprintf("[%d] hashDefinition(%s, %s, %d) (%s)\n",
+			  PL_thread_self(),
+			  predicateName(ctx->predicate),
+			  iargsName(hints->args, NULL), 2<<hints->ln_buckets,
+			  hints->list ? "lists" : "clauses"));
+
+#if defined(O_PLMT) && defined(O_DEBUG)
+{ GET_LD
+  assert(LD->thread.info->access.predicate == ctx->predicate);
+}
+#endif
+
+  canonicalHap(hints->args);
   LOCKDEF(ctx->predicate);
   if ( (cip=clist->clause_indexes) )
   { for(; *cip; cip++)
@@ -2589,7 +3409,7 @@ assess_remove_duplicates(hash_assessment *a, size_t clause_count)
       *++o = *s;
     } else
     { o->count  += s->count;
-      s->nvcomp += s->nvcomp;
+      o->nvcomp += s->nvcomp;
     }
   }
   if ( i > 0 && clause_count )
@@ -2723,6 +3543,7 @@ skipToTerm(Clause clause, const iarg_t *position, int *in_hvoid)
       case H_VAR:
       case H_VOID:
       case H_VOID_N:
+      case H_CONST2:
       case H_POP:
       case I_EXITCATCH:
       case I_EXITRESET:
@@ -2846,7 +3667,7 @@ assess_scan_clauses(ClauseList clist, iarg_t ac,
     { if ( kpp[0] > carg )
 	pc = skipArgs(pc, kpp[0]-carg, &h_void);
       carg = kpp[0];
-      argKey(pc, 0, &keys[kpp[0]]);
+      argKeyAt(pc, h_void, &keys[kpp[0]]);
       nvcomp[kpp[0]] = false;
 						/* see whether this a compound */
       if ( isFunctor(keys[kpp[0]]) )		/* with nonvar args */
@@ -3442,6 +4263,734 @@ set_candidate_indexes(Definition def, ClauseList clist, int max, bool lock)
 }
 
 
+		 /*******************************
+		 *          INDEX HINTS         *
+		 *******************************/
+
+/* Fill `hints` with the configuration of the toplevel indexes of `def`,
+ * both realised and virtual.  This is used to save the indexes with the
+ * predicate in a saved state or .qlf file such that loading can restore
+ * them without assessing the clauses.  Deep indexes are not included;
+ * JITI recreates them when the list index is used.
+ *
+ * @param fixed is set to `true` if the candidate indexes have been
+ * established by set_candidate_indexes().
+ * @return the number of hints filled.
+ */
+
+int
+get_index_hints(Definition def, hash_hints *hints, int max, bool *fixed)
+{
+#ifdef O_PLMT
+  GET_LD
+#endif
+  ClauseList clist = &def->impl.clauses;
+  ClauseIndex *cip;
+  int count = 0;
+
+  acquire_def(def);
+  if ( (cip=clist->clause_indexes) )
+  { for(; *cip && count < max; cip++)
+    { ClauseIndex ci = *cip;
+      hash_hints *h;
+
+      if ( ISDEADCI(ci) || ci->invalid )
+	continue;
+
+      h = &hints[count++];
+      memset(h, 0, sizeof(*h));
+      memcpy(h->args, ci->args, sizeof(h->args));
+      h->ln_buckets = (MSB(ci->buckets)-1)&0x1f;
+      h->speedup    = ci->speedup;
+      h->list       = ci->is_list;
+    }
+  }
+  *fixed = clist->fixed_indexes;
+  release_def(def);
+
+  return count;
+}
+
+		 /*******************************
+		 *	  PERFECT HASHING	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+perfectHashDefinition() computes a  perfect  hash   for  the  index on a
+single argument described by `h`, i.e., a mapping of the distinct keys
+of this argument to buckets such that no two keys share a bucket.  It is
+used by qsave_program/2 with the option perfect_hash(true), which saves
+the hash with the index hints.  The loaded index uses the hash through
+bucketIndex(), so a lookup is a single probe without collision chains.
+
+We use "hash and displace": the keys are hashed into `groups` groups
+of about 4 keys.  Starting with the largest group, we search for a
+displacement that places all keys of the group in free buckets.  The
+hash is based on perfect_key(), so it remains valid after the program is
+loaded into a new process.  Keys that have the same perfect_key() share a
+bucket; this is correct, but not perfect.  The index must have at least
+as many buckets as keys.  If the keys fill more than 3/4 of the buckets
+we double their number, updating h->ln_buckets.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define PH_KEYS_PER_GROUP	4
+#define PH_MAX_DISPLACE		(1<<20)
+#define PH_MAX_SEEDS		8
+
+perfect_hash *
+newPerfectHash(unsigned int groups)
+{ perfect_hash *ph = allocHeapOrHalt(sizeof(*ph) + groups*sizeof(uint32_t));
+
+  ph->seed   = 0;
+  ph->groups = groups;
+  memset(ph->displace, 0, groups*sizeof(uint32_t));
+
+  return ph;
+}
+
+void
+freePerfectHash(perfect_hash *ph)
+{ freeHeap(ph, sizeof(*ph) + ph->groups*sizeof(uint32_t));
+}
+
+typedef struct ph_group
+{ unsigned int	group;			/* Group number */
+  unsigned int	start;			/* First key in sorted keys */
+  unsigned int	count;			/* # keys in this group */
+} ph_group;
+
+static int
+compare_u64(const void *p1, const void *p2)
+{ uint64_t k1 = *(const uint64_t*)p1;
+  uint64_t k2 = *(const uint64_t*)p2;
+
+  return SCALAR_TO_CMP(k1, k2);
+}
+
+static int
+compare_ph_group(const void *p1, const void *p2)
+{ const ph_group *g1 = p1;
+  const ph_group *g2 = p2;
+
+  return SCALAR_TO_CMP(g2->count, g1->count);
+}
+
+static int
+compare_ph_key_group(const void *p1, const void *p2, void *ctx)
+{ unsigned int mask = *(const unsigned int*)ctx;
+  uint64_t g1 = *(const uint64_t*)p1 & mask;
+  uint64_t g2 = *(const uint64_t*)p2 & mask;
+
+  return SCALAR_TO_CMP(g1, g2);
+}
+
+static bool
+place_perfect_hash(perfect_hash *ph, uint64_t *hashes, size_t nkeys,
+		   unsigned int buckets, bit_vector *used)
+{ unsigned int mask = ph->groups-1;
+  ph_group *groups = malloc(ph->groups*sizeof(*groups));
+  unsigned int slots[64];
+  bool rc = true;
+
+  if ( !groups )
+    return false;
+
+  for(size_t i=0; i<nkeys; i++)
+    hashes[i] = mix64(hashes[i]^ph->seed);
+					/* sort keys by group */
+  sort_r(hashes, nkeys, sizeof(*hashes), compare_ph_key_group, &mask);
+  memset(groups, 0, ph->groups*sizeof(*groups));
+  for(unsigned int g=0; g<ph->groups; g++)
+    groups[g].group = g;
+  for(size_t i=0; i<nkeys; i++)
+  { ph_group *g = &groups[hashes[i]&mask];
+
+    if ( g->count++ == 0 )
+      g->start = (unsigned int)i;
+  }
+  qsort(groups, ph->groups, sizeof(*groups), compare_ph_group);
+
+  clear_bitvector(used);
+  for(unsigned int gi=0; gi<ph->groups && groups[gi].count; gi++)
+  { ph_group *g = &groups[gi];
+    uint32_t d;
+
+    if ( g->count > 64 )
+    { rc = false;
+      break;
+    }
+
+    for(d=0; d<PH_MAX_DISPLACE; d++)
+    { unsigned int n;
+
+      ph->displace[g->group] = d;
+      for(n=0; n<g->count; n++)
+      { unsigned int b = perfectHashIndex(ph, hashes[g->start+n], buckets);
+	unsigned int j;
+
+	if ( true_bit(used, b) )
+	  break;
+	for(j=0; j<n && slots[j] != b; j++)
+	  ;
+	if ( j < n )
+	  break;
+	slots[n] = b;
+      }
+      if ( n == g->count )
+      { for(n=0; n<g->count; n++)
+	  set_bit(used, slots[n]);
+	break;
+      }
+    }
+    if ( d == PH_MAX_DISPLACE )
+    { rc = false;
+      break;
+    }
+  }
+
+  free(groups);
+  return rc;
+}
+
+perfect_hash *
+perfectHashDefinition(Definition def, hash_hints *h)
+{
+#ifdef O_PLMT
+  GET_LD
+#endif
+  ClauseList clist = &def->impl.clauses;
+  perfect_hash *ph = NULL;
+  size_t nkeys = 0, size;
+  uint64_t *keys;
+
+  if ( h->list || h->args[0] == 0 || h->args[1] != 0 ||
+       ison(def, P_DYNAMIC|P_FOREIGN|P_THREAD_LOCAL) )
+    return NULL;
+
+  acquire_def(def);
+  size = clist->number_of_clauses;
+  if ( !(keys = malloc((size+1)*sizeof(*keys))) )
+  { release_def(def);
+    return NULL;
+  }
+  for(ClauseRef cref = clist->first_clause;
+      cref && nkeys < size;
+      cref = cref->next)
+  { Clause cl = cref->value.clause;
+    word key;
+
+    if ( ison(cl, CL_ERASED) )
+      continue;
+    if ( argKey(cl->codes, h->args[0]-1, &key) && key )
+      keys[nkeys++] = perfect_key(key);
+  }
+  release_def(def);
+
+  if ( nkeys > 0 )			/* unique the keys */
+  { size_t o = 0;
+
+    qsort(keys, nkeys, sizeof(*keys), compare_u64);
+    for(size_t i=1; i<nkeys; i++)
+    { if ( keys[i] != keys[o] )
+	keys[++o] = keys[i];
+    }
+    nkeys = o+1;
+  }
+
+  unsigned int ln_buckets = h->ln_buckets;
+  unsigned int buckets = 2<<ln_buckets;
+
+  while ( nkeys > (size_t)buckets/4*3 && ln_buckets < 30 )
+  { ln_buckets++;
+    buckets *= 2;
+  }
+
+  if ( nkeys > 0 && nkeys <= (size_t)buckets/4*3 )
+  { unsigned int groups = 1;
+    uint64_t *hashes = malloc(nkeys*sizeof(*hashes));
+    bit_vector *used = new_bitvector(buckets);
+
+    while ( groups*PH_KEYS_PER_GROUP < nkeys )
+      groups *= 2;
+    ph = newPerfectHash(groups);
+
+    for(int try=0; hashes && used && try < PH_MAX_SEEDS; try++)
+    { ph->seed = mix64(try+1);
+      memcpy(hashes, keys, nkeys*sizeof(*hashes));
+      if ( place_perfect_hash(ph, hashes, nkeys, buckets, used) )
+      { h->ln_buckets = ln_buckets&0x1f;
+	break;
+      }
+      if ( try+1 == PH_MAX_SEEDS )
+      { freePerfectHash(ph);
+	ph = NULL;
+      }
+    }
+    if ( !hashes || !used )
+    { freePerfectHash(ph);
+      ph = NULL;
+    }
+
+    if ( used )
+      free_bitvector(used);
+    free(hashes);
+  }
+  free(keys);
+
+  DEBUG(MSG_JIT, Sdprintf("Perfect hash for %s: %zd keys, %s\n",
+			  predicateName(def), nkeys,
+			  ph ? "ok" : "failed"));
+
+  return ph;
+}
+
+
+/* Restore indexes  from hints obtained  using get_index_hints().  The
+ * indexes are added as virtual indexes that are realised on first use.
+ * Hints that do not apply to `def` are ignored.
+ */
+
+static void
+add_index_hints(Definition def, hash_hints *hints, int count)
+{ ClauseList clist = &def->impl.clauses;
+  index_context ctx = { .predicate = def, .position[0] = END_INDEX_POS };
+  size_t ac = def->functor->arity > MAXINDEXARG ? MAXINDEXARG
+						: def->functor->arity;
+
+  for(int i=0; i<count; i++)
+  { hash_hints *h = &hints[i];
+    ClauseIndex *from = clist->clause_indexes;
+    bool ok = h->args[0] > 0;
+
+    canonicalHap(h->args);
+    for(int j=0; ok && j<MAX_MULTI_INDEX && h->args[j]; j++)
+    { if ( h->args[j] > ac )
+	ok = false;
+    }
+    if ( ok && !get_existing_index(&from, h) )
+    { ClauseIndex ci = newClauseIndexTable(h, false, &ctx);
+
+      ci->perfect = h->perfect;
+      h->perfect = NULL;
+      insertIndex(def, clist, ci);
+    } else if ( h->perfect )
+    { freePerfectHash(h->perfect);
+      h->perfect = NULL;
+    }
+  }
+}
+
+
+void
+set_index_hints(Definition def, hash_hints *hints, int count, bool fixed)
+{ LOCKDEF(def);
+  add_index_hints(def, hints, count);
+  if ( fixed && isoff(def, P_DYNAMIC) )
+    def->impl.clauses.fixed_indexes = true;
+  UNLOCKDEF(def);
+}
+
+
+/* Indexes for thread-local predicates.  The clauses of a thread-local
+ * predicate are  private to  a thread, but  the threads  typically use
+ * the predicate  in the same  way.  If a  thread creates an  index for
+ * its  local definition,  shareLocalIndex() records  its hints  on the
+ * thread-local  predicate.  localiseDefinition()  calls
+ * seedLocalIndexes() to  add these  as virtual  indexes to  new local
+ * definitions, such that  the threads do not need to  assess the
+ * clauses to find them.
+ */
+
+static void
+shareLocalIndex(DECL_LD Definition local, const hash_hints *hints)
+{ Procedure proc = isCurrentProcedure(local->functor->functor,
+				      local->module);
+  Definition def;
+
+  if ( !proc || isoff((def=proc->definition), P_THREAD_LOCAL) )
+    return;
+
+  LocalDefinitions v = def->impl.local.local;
+
+  LOCKDEF(def);
+  if ( v && v->index_hint_count < MAX_LOCAL_INDEX_HINTS )
+  { for(int i=0; i<v->index_hint_count; i++)
+    { if ( memcmp(v->index_hints[i].args, hints->args,
+		  sizeof(hints->args)) == 0 )
+      { UNLOCKDEF(def);
+	return;
+      }
+    }
+
+    if ( !v->index_hints )
+      v->index_hints = allocHeapOrHalt(MAX_LOCAL_INDEX_HINTS*
+				       sizeof(*v->index_hints));
+    hash_hints *h = &v->index_hints[v->index_hint_count];
+    *h = *hints;
+    h->perfect = NULL;
+    MEMORY_RELEASE();
+    v->index_hint_count++;
+  }
+  UNLOCKDEF(def);
+}
+
+
+/* Called from localiseDefinition(), which may hold L_PREDICATE.  Hints
+ * are not changed after they are published, so we can copy them without
+ * locking.  The new local definition is not yet visible to other threads.
+ */
+
+void
+seedLocalIndexes(Definition local, Definition def)
+{ LocalDefinitions v = def->impl.local.local;
+  hash_hints hints[MAX_LOCAL_INDEX_HINTS];
+  int count;
+
+  if ( (count=v->index_hint_count) > 0 )
+  { MEMORY_ACQUIRE();
+    memcpy(hints, v->index_hints, count*sizeof(*hints));
+    add_index_hints(local, hints, count);
+  }
+}
+
+
+		 /*******************************
+		 *         RANGE INDEXES        *
+		 *******************************/
+
+/* A range index is an array of the clauses of a predicate, sorted on
+ * the  standard order  of one  of its  arguments.  It  allows finding
+ * the clauses  for which  this argument  is in a  given range  without
+ * scanning  all clauses.  Only  atoms and  numbers are  ordered.  The
+ * other clauses, notably those with  a variable at this argument, are
+ * kept in a separate array and are always candidates.
+ *
+ * Range  indexes are  created on  first  use by  '$clause_range'/5 and
+ * remain valid as long as the  predicate is not modified.  Numbers are
+ * ordered as  doubles.  This  is conservative: we may  return clauses
+ * outside the range, but  never skip one that is in  it.  The caller
+ * must verify the actual value.
+ */
+
+#define RK_BELOW	0		/* Below all numbers */
+#define RK_NUMBER	1		/* A number, ordered as double */
+#define RK_ATOM		2		/* An atom */
+#define RK_ABOVE	3		/* Above all atoms */
+
+typedef struct range_key
+{ int		type;			/* RK_* */
+  union
+  { double	f;			/* RK_NUMBER */
+    atom_t	a;			/* RK_ATOM */
+  } value;
+} range_key;
+
+typedef struct range_entry
+{ range_key	key;			/* Key of the clause */
+  Clause	clause;			/* The clause */
+  size_t	order;			/* Position in the clause list */
+} range_entry;
+
+struct range_index
+{ RangeIndex	next;			/* Next range index */
+  unsigned int	arg;			/* Indexed argument (1-based) */
+  gen_t		modified;		/* Predicate generation it reflects */
+  size_t	size;			/* # ordered entries */
+  size_t	unordered_count;	/* # unordered clauses */
+  range_entry  *entries;		/* Ordered entries */
+  Clause       *unordered;		/* Other clauses in clause order */
+};
+
+/* Get the range key for the `arg`-th argument of the head of `cl`.
+ * This is similar to argKey(), but only deals with atoms and numbers.
+ *
+ * @return `false` if the argument is not an atom or number.
+ */
+
+static bool
+rangeKeyFromClause(Clause cl, unsigned int arg, range_key *k)
+{ int h_void = 0;
+  Code PC = cl->codes;
+
+  if ( arg > 1 )
+    PC = skipArgs(PC, arg-1, &h_void);
+  if ( h_void && decode(*PC) != H_CONST2 )
+    return false;
+
+  for(;;)
+  { code c = decode(*PC++);
+
+#if O_DEBUGGER
+  again:
+#endif
+    switch(c)
+    { case H_ATOM:
+	k->type = RK_ATOM;
+	k->value.a = code2atom(*PC);
+	return true;
+#ifdef O_CONST2
+      case H_CONST2:
+      { word w = code2const(*PC, h_void ? 1 : 0);
+
+	if ( isAtom(w) )
+	{ k->type = RK_ATOM;
+	  k->value.a = word2atom(w);
+	} else
+	{ k->type = RK_NUMBER;
+	  k->value.f = (double)valInt(w);
+	}
+	return true;
+      }
+#endif
+      case H_NIL:
+	k->type = RK_ATOM;
+	k->value.a = ATOM_nil;
+	return true;
+      case H_SMALLINT:
+      { scode i = *PC;
+	k->type = RK_NUMBER;
+	k->value.f = (double)i;
+	return true;
+      }
+#if CODES_PER_WORD > 1
+      case H_SMALLINTW:
+      { word m;
+	code_get_word(PC, &m);
+	k->type = RK_NUMBER;
+	k->value.f = (double)(sword)m;
+	return true;
+      }
+#endif
+      case H_FLOAT:
+      { double f;
+
+	memcpy(&f, PC, sizeof(f));
+	if ( isnan(f) )
+	  return false;
+	k->type = RK_NUMBER;
+	k->value.f = f;
+	return true;
+      }
+      case I_NOP:
+      case I_CHP:
+	continue;
+#ifdef O_DEBUGGER
+      case D_BREAK:
+	c = decode(replacedBreak(PC-1));
+	goto again;
+#endif
+      default:
+	return false;
+    }
+  }
+}
+
+static int
+compareRangeKeys(const range_key *k1, const range_key *k2)
+{ if ( k1->type != k2->type )
+    return SCALAR_TO_CMP(k1->type, k2->type);
+
+  switch(k1->type)
+  { case RK_NUMBER:
+      return SCALAR_TO_CMP(k1->value.f, k2->value.f);
+    case RK_ATOM:
+      return compareAtoms(k1->value.a, k2->value.a);
+    default:
+      return CMP_EQUAL;
+  }
+}
+
+static int
+cmp_range_entries(const void *p1, const void *p2)
+{ const range_entry *e1 = p1;
+  const range_entry *e2 = p2;
+  int rc;
+
+  if ( (rc=compareRangeKeys(&e1->key, &e2->key)) != CMP_EQUAL )
+    return rc;
+
+  return SCALAR_TO_CMP(e1->order, e2->order);
+}
+
+static RangeIndex
+newRangeIndex(Definition def, unsigned int arg)
+{ ClauseList clist = &def->impl.clauses;
+  RangeIndex ri = allocHeapOrHalt(sizeof(*ri));
+  tmp_buffer ordered, unordered;
+  size_t order = 0;
+
+  memset(ri, 0, sizeof(*ri));
+  ri->arg      = arg;
+  ri->modified = def->last_modified;
+
+  initBuffer(&ordered);
+  initBuffer(&unordered);
+  for(ClauseRef cref = clist->first_clause; cref; cref = cref->next)
+  { Clause cl = cref->value.clause;
+    range_entry e;
+
+    if ( rangeKeyFromClause(cl, arg, &e.key) )
+    { e.clause = cl;
+      e.order  = order++;
+      addBuffer(&ordered, e, range_entry);
+    } else
+    { addBuffer(&unordered, cl, Clause);
+    }
+  }
+
+  if ( (ri->size = entriesBuffer(&ordered, range_entry)) )
+  { size_t bytes = ri->size*sizeof(range_entry);
+
+    ri->entries = allocHeapOrHalt(bytes);
+    memcpy(ri->entries, baseBuffer(&ordered, range_entry), bytes);
+    qsort(ri->entries, ri->size, sizeof(range_entry), cmp_range_entries);
+  }
+  if ( (ri->unordered_count = entriesBuffer(&unordered, Clause)) )
+  { size_t bytes = ri->unordered_count*sizeof(Clause);
+
+    ri->unordered = allocHeapOrHalt(bytes);
+    memcpy(ri->unordered, baseBuffer(&unordered, Clause), bytes);
+  }
+  discardBuffer(&ordered);
+  discardBuffer(&unordered);
+
+  DEBUG(MSG_JIT,
+	Sdprintf("Created range index for arg %d of %s: %zd ordered, "
+		 "%zd other\n",
+		 arg, predicateName(def), ri->size, ri->unordered_count));
+
+  return ri;
+}
+
+static size_t
+sizeofRangeIndex(RangeIndex ri)
+{ return ( sizeof(*ri) +
+	   ri->size*sizeof(range_entry) +
+	   ri->unordered_count*sizeof(Clause) );
+}
+
+static void
+freeRangeIndex(RangeIndex ri)
+{ if ( ri->entries )
+    freeHeap(ri->entries, ri->size*sizeof(range_entry));
+  if ( ri->unordered )
+    freeHeap(ri->unordered, ri->unordered_count*sizeof(Clause));
+  freeHeap(ri, sizeof(*ri));
+}
+
+static void
+vfreeRangeIndex(void *ri)
+{ freeRangeIndex(ri);
+}
+
+static void
+deleteRangeIndexes(Definition def)
+{ RangeIndex ri, next;
+
+  for(ri=def->impl.clauses.range_indexes; ri; ri=next)
+  { next = ri->next;
+    freeRangeIndex(ri);
+  }
+  def->impl.clauses.range_indexes = NULL;
+}
+
+/* Find or create  the range index for `arg`.  Indexes  that no longer
+ * reflect the  predicate are unlinked  and freed after  other threads
+ * stopped using them.  Inside a transaction  we cannot use the shared
+ * indexes and create a temporary one  that must be freed by the caller
+ * if `*tmp` is set to `true`.
+ *
+ * Must be called with `def` acquired.
+ */
+
+#define getRangeIndex(def, arg, tmp) LDFUNC(getRangeIndex, def, arg, tmp)
+
+static RangeIndex
+getRangeIndex(DECL_LD Definition def, unsigned int arg, bool *tmp)
+{ ClauseList clist = &def->impl.clauses;
+  RangeIndex ri, *rip;
+
+  if ( unlikely(!!LD->transaction.generation) && ison(def, P_TRANSACT) )
+  { *tmp = true;
+    return newRangeIndex(def, arg);
+  }
+
+  *tmp = false;
+  LOCKDEF(def);
+  for(ri=clist->range_indexes; ri; ri=ri->next)
+  { if ( ri->arg == arg && ri->modified == def->last_modified )
+    { UNLOCKDEF(def);
+      return ri;
+    }
+  }
+
+  for(rip=&clist->range_indexes; (ri=*rip); )
+  { if ( ri->modified != def->last_modified )
+    { *rip = ri->next;
+      linger_always(&def->lingering, vfreeRangeIndex, ri);
+    } else
+    { rip = &ri->next;
+    }
+  }
+
+  ri = newRangeIndex(def, arg);
+  ri->next = clist->range_indexes;
+  MEMORY_RELEASE();
+  clist->range_indexes = ri;
+  UNLOCKDEF(def);
+
+  return ri;
+}
+
+/* Index of the first entry of `ri` whose key is not below `k`
+ */
+
+static size_t
+rangeLowerBound(RangeIndex ri, const range_key *k)
+{ size_t lo = 0, hi = ri->size;
+
+  while( lo < hi )
+  { size_t mid = lo + (hi-lo)/2;
+
+    if ( compareRangeKeys(&ri->entries[mid].key, k) == CMP_LESS )
+      lo = mid+1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* Translate a bound of '$clause_range'/5 into a key.  An unbound bound
+ * means there is no limit.  A NaN  is the smallest float in the standard
+ * order of terms.
+ */
+
+#define get_range_bound(t, k, high) LDFUNC(get_range_bound, t, k, high)
+
+static void
+get_range_bound(DECL_LD term_t t, range_key *k, bool high)
+{ atom_t a;
+  double f;
+
+  if ( PL_is_variable(t) )
+  { k->type = high ? RK_ABOVE : RK_BELOW;
+  } else if ( PL_is_number(t) )
+  { if ( PL_get_float(t, &f) )
+    { k->type = RK_NUMBER;
+      k->value.f = isnan(f) ? -INFINITY : f;
+    } else
+    { k->type = high ? RK_ABOVE : RK_BELOW;
+    }
+  } else if ( PL_get_atom(t, &a) )
+  { k->type = RK_ATOM;
+    k->value.a = a;
+  } else
+  { k->type = RK_ABOVE;
+  }
+}
+
+
 		 /*******************************
 		 *      PROLOG CONNECTION       *
 		 *******************************/
@@ -3568,6 +5117,233 @@ PRED_IMPL("$candidate_indexes", 3, candidate_indexes, PL_FA_TRANSPARENT)
   return rc;
 }
 
+/** '$clause_range'(:Head, +Arg, ?Low, ?High, -Refs)
+ *
+ * Refs is a list of references to the  visible clauses of Head whose
+ * Arg-th argument may be in the range  Low..High in the standard order
+ * of terms.  Unbound  bounds do not limit the range.   The clauses are
+ * ordered by the value of  the argument, followed by clauses where this
+ * argument is not an atom or number in clause order.
+ */
+
+static
+PRED_IMPL("$clause_range", 5, clause_range, PL_FA_TRANSPARENT)
+{ PRED_LD
+  Procedure proc;
+  int arg;
+  range_key low, high;
+
+  if ( !get_procedure(A1, &proc, 0, GP_RESOLVE) ||
+       !PL_get_integer_ex(A2, &arg) )
+    return false;
+
+  Definition def = getProcDefinition(proc);
+  if ( ison(def, P_FOREIGN) )
+    return PL_error(NULL, 0, NULL, ERR_PERMISSION_PROC,
+		    ATOM_access, ATOM_private_procedure, proc);
+  if ( arg < 1 || (size_t)arg > def->functor->arity )
+    return PL_domain_error("argument_index", A2);
+
+  get_range_bound(A3, &low, false);
+  get_range_bound(A4, &high, true);
+
+  gen_t gen = current_generation(def);
+  tmp_buffer buf;
+  bool tmp;
+
+  initBuffer(&buf);
+  acquire_def(def);
+  RangeIndex ri = getRangeIndex(def, arg, &tmp);
+  for(size_t i=rangeLowerBound(ri, &low); i < ri->size; i++)
+  { range_entry *e = &ri->entries[i];
+
+    if ( compareRangeKeys(&e->key, &high) == CMP_GREATER )
+      break;
+    if ( visibleClause(e->clause, gen) )
+    { acquire_clause(e->clause);
+      addBuffer(&buf, e->clause, Clause);
+    }
+  }
+  for(size_t i=0; i < ri->unordered_count; i++)
+  { Clause cl = ri->unordered[i];
+
+    if ( visibleClause(cl, gen) )
+    { acquire_clause(cl);
+      addBuffer(&buf, cl, Clause);
+    }
+  }
+  release_def(def);
+  if ( tmp )
+    freeRangeIndex(ri);
+
+  term_t tail = PL_copy_term_ref(A5);
+  term_t head = PL_new_term_ref();
+  Clause *cp  = baseBuffer(&buf, Clause);
+  size_t  cnt = entriesBuffer(&buf, Clause);
+  bool rc = true;
+
+  for(size_t i=0; i<cnt; i++)
+  { if ( rc )
+      rc = ( PL_unify_list(tail, head, tail) &&
+	     PL_unify_clref(head, cp[i]) );
+    release_clause(cp[i]);
+  }
+  discardBuffer(&buf);
+
+  return rc && PL_unify_nil(tail);
+}
+
+/** '$index_advice'(-Advice:list, +Clear:boolean)
+ *
+ * Advice is a list of advice(PI, Args, Calls, Visits, Clauses) terms
+ * for the call modes sampled  by sample_scan().  Args is the list of
+ * 1-based  instantiated  arguments.    If  Clear  is  `true`,  the
+ * collected data is deleted.
+ */
+
+typedef struct advice_entry
+{ atom_t	module;
+  functor_t	functor;
+  size_t	clauses;
+  advice_mode	mode;
+} advice_entry;
+
+static
+PRED_IMPL("$index_advice", 2, index_advice, 0)
+{ PRED_LD
+  int clear;
+  tmp_buffer buf;
+
+  if ( !PL_get_bool_ex(A2, &clear) )
+    return false;
+
+  initBuffer(&buf);
+  PL_LOCK(L_MISC);
+  if ( GD->clause_index.advice )
+  { FOR_TABLE(GD->clause_index.advice, k, v)
+    { index_advice *a = val2ptr(v);
+      Definition def = a->predicate;
+
+      if ( def->module )
+      { for(int i=0; i<MAX_ADVICE_MODES && a->modes[i].mask; i++)
+	{ advice_entry e = { .module  = def->module->name,
+			     .functor = def->functor->functor,
+			     .clauses = def->impl.clauses.number_of_clauses,
+			     .mode    = a->modes[i]
+			   };
+	  PL_register_atom(e.module);
+	  addBuffer(&buf, e, advice_entry);
+	}
+      }
+      if ( clear )
+	freeHeap(a, sizeof(*a));
+    }
+    if ( clear )
+      clearHTableWP(GD->clause_index.advice);
+  }
+  PL_UNLOCK(L_MISC);
+
+  term_t tail = PL_copy_term_ref(A1);
+  term_t head = PL_new_term_ref();
+  term_t args = PL_new_term_ref();
+  term_t arg  = PL_new_term_ref();
+  advice_entry *ep = baseBuffer(&buf, advice_entry);
+  size_t cnt = entriesBuffer(&buf, advice_entry);
+  bool rc = true;
+
+  for(size_t i=0; i<cnt; i++)
+  { advice_entry *e = &ep[i];
+
+    if ( rc )
+    { PL_put_nil(args);
+      for(int a=64; a>0; a--)
+      { if ( (e->mode.mask & ((uint64_t)1<<(a-1))) )
+	{ if ( !PL_put_integer(arg, a) ||
+	       !PL_cons_list(args, arg, args) )
+	  { rc = false;
+	    break;
+	  }
+	}
+      }
+      rc = ( rc &&
+	     PL_unify_list(tail, head, tail) &&
+	     PL_unify_term(head,
+			   PL_FUNCTOR_CHARS, "advice", 5,
+			     PL_FUNCTOR, FUNCTOR_colon2,
+			       PL_ATOM, e->module,
+			       PL_FUNCTOR, FUNCTOR_divide2,
+				 PL_ATOM, nameFunctor(e->functor),
+				 PL_INT64, (int64_t)arityFunctor(e->functor),
+			     PL_TERM, args,
+			     PL_INT64, (int64_t)e->mode.calls,
+			     PL_INT64, (int64_t)e->mode.visits,
+			     PL_INT64, (int64_t)e->clauses) );
+    }
+    PL_unregister_atom(e->module);
+  }
+  discardBuffer(&buf);
+
+  return rc && PL_unify_nil(tail);
+}
+
+
+/** '$jiti_add_index'(:Head, -Args)
+ *
+ * Create the index that  JITI would create for a call  to Head, i.e.,
+ * considering the  instantiated arguments of  Head.  If the  index is
+ * created or already  exists, Args is unified with the  list of its
+ * arguments.  Fails if no index is worthwhile.
+ */
+
+static
+PRED_IMPL("$jiti_add_index", 2, jiti_add_index, PL_FA_TRANSPARENT)
+{ PRED_LD
+  Procedure proc;
+  Module m = NULL;
+  term_t head = PL_new_term_ref();
+
+  if ( !PL_strip_module(A1, &m, head) ||
+       !get_procedure(A1, &proc, 0, GP_FIND) )
+    return false;
+
+  Definition def = getProcDefinition(proc);
+  if ( ison(def, P_FOREIGN) )
+    return PL_error(NULL, 0, NULL, ERR_PERMISSION_PROC,
+		    ATOM_access, ATOM_private_procedure, proc);
+
+  size_t arity = def->functor->arity;
+  if ( arity == 0 )
+    return false;
+
+  Word argv = valTermRef(head);
+  deRef(argv);
+  argv = argTermP(*argv, 0);
+
+  index_context ctx = { .generation  = global_generation(),
+			.predicate   = def,
+			.depth	     = 0,
+			.position[0] = END_INDEX_POS
+		      };
+  iarg_t args[MAX_MULTI_INDEX];
+  ClauseIndex ci;
+  int retry = 10;
+
+  acquire_def(def);
+  do
+  { ci = createIndex(argv, arity, &def->impl.clauses, NULL, &ctx);
+  } while ( ci == CI_RETRY && --retry > 0 );
+  if ( ci && ci != CI_RETRY )
+    memcpy(args, ci->args, sizeof(args));
+  release_def(def);
+
+  if ( !ci || ci == CI_RETRY )
+    return false;
+
+  term_t tmp = PL_new_term_ref();
+  return ( put_args(tmp, args) &&
+	   PL_unify(A2, tmp) );
+}
+
 		 /*******************************
 		 *      PRIMARY INDEX ARG       *
 		 *******************************/
@@ -3759,6 +5535,8 @@ sizeofClauseIndex(ClauseIndex ci)
     }
     size += vars * ci->buckets * usize;
   }
+  if ( ci->bloom )
+    size += sizeofBloomFilter(ci->bloom);
 
   return size;
 }
@@ -3786,6 +5564,12 @@ sizeofClauseIndexes(Definition def)
     }
     release_def(def);
   }
+  if ( def->impl.clauses.range_indexes )
+  { acquire_def(def);
+    for(RangeIndex ri=def->impl.clauses.range_indexes; ri; ri=ri->next)
+      size += sizeofRangeIndex(ri);
+    release_def(def);
+  }
 
   return size;
 }
@@ -3817,9 +5601,11 @@ collisionCount(const ClauseIndex ci)
  *   - size: Bytes used for the index
  *   - realised: bool indicating whether the index is realised.
  *   - collisions: # buckets that represent multiple keys
+ *   - bloom: estimated false positive rate of the Bloom filter.  Only
+ *     present if the index has a Bloom filter.
  */
 
-#define NUM_INDEX_KEYS 8
+#define NUM_INDEX_KEYS 9
 static atom_t i_tag_hash = 0;
 static atom_t i_index_keys[NUM_INDEX_KEYS];
 
@@ -3834,7 +5620,8 @@ init_index_keys(void)
     i_index_keys[5] = PL_new_atom("size");
     i_index_keys[6] = PL_new_atom("realised");
     i_index_keys[7] = PL_new_atom("collisions");
-    // NUM_INDEX_KEYS = 8
+    i_index_keys[8] = PL_new_atom("bloom");
+    // NUM_INDEX_KEYS = 9
     i_tag_hash = PL_new_atom("hash");
   }
 }
@@ -3873,9 +5660,16 @@ unify_clause_index(DECL_LD term_t t, ClauseIndex ci)
        !PL_unify_int64(values+7, collisionCount(ci)) )
     return false;
 
+  int nkeys = NUM_INDEX_KEYS-1;
+  if ( ci->bloom )
+  { if ( !PL_unify_float(values+8, bloomFalsePositiveRate(ci->bloom)) )
+      return false;
+    nkeys++;
+  }
+
   init_index_keys();
 
-  bool rc = ( PL_put_dict(tmp, i_tag_hash, NUM_INDEX_KEYS, i_index_keys,
+  bool rc = ( PL_put_dict(tmp, i_tag_hash, nkeys, i_index_keys,
 			  values) &&
 	      PL_unify(t, tmp) );
 
@@ -3988,6 +5782,10 @@ static ci_flag ciflags[] =
   CI_FFLAG(min_speedup_ratio),
   CI_IFLAG(max_lookahead),
   CI_IFLAG(min_clauses),
+  CI_IFLAG(fill_threads),
+  CI_IFLAG(fill_min_clauses),
+  CI_IFLAG(bloom_bits),
+  CI_IFLAG(sample),
   { .name = 0 }
 };
 
@@ -4063,6 +5861,10 @@ initClauseIndexing(void)
   CI_CONF(min_speedup_ratio) = 3.0f;
   CI_CONF(max_lookahead)     = 100;
   CI_CONF(min_clauses)       = 10;
+  CI_CONF(fill_threads)      = CpuCount() > 16 ? 16 : CpuCount();
+  CI_CONF(fill_min_clauses)  = 100000;
+  CI_CONF(bloom_bits)        = 8;
+  CI_CONF(sample)            = 0;
 
   for(ci_flag *f = ciflags; f->name; f++)
   { f->symbol = 0;		/* allow restarting */
@@ -4083,4 +5885,7 @@ initClauseIndexing(void)
 BeginPredDefs(index)
   PRED_DEF("$candidate_indexes",     3, candidate_indexes,     META)
   PRED_DEF("$set_candidate_indexes", 2, set_candidate_indexes, META)
+  PRED_DEF("$clause_range",          5, clause_range,          META)
+  PRED_DEF("$index_advice",          2, index_advice,          0)
+  PRED_DEF("$jiti_add_index",        2, jiti_add_index,        META)
 EndPredDefs
@@ -39,6 +39,42 @@
 #ifndef _PL_INDEX_H
 #define _PL_INDEX_H
 
+		 /*******************************
+		 *	       TYPES		*
+		 *******************************/
+
+typedef struct perfect_hash
+{ uint64_t	seed;			/* Seed for hashing the keys */
+  unsigned int	groups;			/* # displacements (power of 2) */
+  uint32_t	displace[];		/* Displacement per group */
+} perfect_hash;
+
+typedef struct hash_hints
+{ float		speedup;		/* Expected speedup */
+  unsigned	list : 1;		/* Use a list per key */
+  unsigned	ln_buckets : 5;		/* Lg2 of #buckets to use */
+  iarg_t	args[MAX_MULTI_INDEX];	/* Hash these arguments */
+  perfect_hash *perfect;		/* Perfect hash for the buckets */
+} hash_hints;
+
+#define MAX_PREPARED_KEYS 4
+#define MAX_LOCAL_INDEX_HINTS 4		/* Shared by thread-local defs */
+
+typedef struct prepared_key
+{ ClauseIndex	ci;			/* Index we prepared for */
+  iarg_t	args[MAX_MULTI_INDEX];	/* Arguments of this index */
+  bool		is_list;		/* Index is a list index */
+  bool		ok;			/* Clause can be added */
+  word		key;			/* Key of the clause */
+  word		arg1key;		/* Key of first argument (list) */
+  ClauseRef	cref;			/* Pre-allocated bucket reference */
+} prepared_key;
+
+typedef struct prepared_keys
+{ int		count;			/* # used entries */
+  prepared_key	keys[MAX_PREPARED_KEYS];
+} prepared_keys;
+
 		 /*******************************
 		 *    FUNCTION DECLARATIONS	*
 		 *******************************/
@@ -46,10 +82,14 @@
 #if USE_LD_MACROS
 #define	firstClause(av, fr, def, next)	LDFUNC(firstClause, av, fr, def, next)
 #define	nextClause(chp, argv, fr, def)	LDFUNC(nextClause, chp, argv, fr, def)
+#define skipGuardedClauses(cref, argv, fr, def, chp) \
+	LDFUNC(skipGuardedClauses, cref, argv, fr, def, chp)
 #define getIndexOfTerm(t)		LDFUNC(getIndexOfTerm, t)
 #define ci_set_flag(value, key)		LDFUNC(ci_set_flag, value, key)
 #define ci_get_flag(term, key)		LDFUNC(ci_get_flag, term, key)
 #define update_primary_index(def)	LDFUNC(update_primary_index, def)
+#define prepareClauseIndexKeys(def, cl, pk) \
+	LDFUNC(prepareClauseIndexKeys, def, cl, pk)
 #endif /*USE_LD_MACROS*/
 
 #define LDFUNC_DECLARATIONS
@@ -59,8 +99,15 @@ ClauseRef	firstClause(Word argv, LocalFrame fr, Definition def,
 			    ClauseChoice next);
 ClauseRef	nextClause(const ClauseChoice chp, const Word argv,
 			   const LocalFrame fr, const Definition def);
+ClauseRef	skipGuardedClauses(ClauseRef cref, const Word argv,
+				   const LocalFrame fr, const Definition def,
+				   const ClauseChoice chp);
+void		prepareClauseIndexKeys(Definition def, Clause cl,
+				       prepared_keys *pk);
+void		releasePreparedKeys(prepared_keys *pk);
+void		forgetIndexAdvice(Definition def);
 int		addClauseToIndexes(Definition def, Clause cl,
-				   ClauseRef where);
+				   ClauseRef where, prepared_keys *pk);
 void		delClauseFromIndex(Definition def, Clause cl);
 void		cleanClauseIndexes(Definition def, ClauseList cl,
 				   DirtyDefInfo ddi,
@@ -81,7 +128,26 @@ bool		ci_set_flag(term_t value, atom_t key);
 bool		ci_get_flag(term_t t, atom_t key);
 void		update_primary_index(Definition def);
 word		index_of_word(word w);
+int		get_index_hints(Definition def, hash_hints *hints, int max,
+				bool *fixed);
+perfect_hash   *perfectHashDefinition(Definition def, hash_hints *h);
+perfect_hash   *newPerfectHash(unsigned int groups);
+void		freePerfectHash(perfect_hash *ph);
+void		set_index_hints(Definition def, hash_hints *hints, int count,
+				bool fixed);
+void		seedLocalIndexes(Definition local, Definition def);
 
 #undef LDFUNC_DECLARATIONS
 
+/* True if skipGuardedClauses() may prune the selected clause or the
+ * candidates for a choicepoint.
+ */
+
+static inline bool
+guardedCandidates(const ClauseRef cref, const ClauseChoice chp)
+{ return ( cref &&
+	   ( ison(cref->value.clause, CL_GUARD) ||
+	     (chp->cref && ison(chp->cref->value.clause, CL_GUARD)) ) );
+}
+
 #endif /*_PL_INDEX_H*/
@@ -754,17 +754,17 @@ clause indexing. ptr is the start of the  data. It is word aligned and n
 is the size in bytes, a multiple of sizeof(word). If the indirect is too
 long we has based on the start, end and length.
 
-The hash should not conflict  with   a  functor_t  (hence the STG_GLOBAL
-mask) and may never be 0.
+The hash may never be 0 and should not conflict with an atom_t, functor_t
+or tagged integer.  We give it the tag TAG_STRING|STG_GLOBAL, which is not
+used by any other key.  This allows perfect_key() in pl-index.c to tell
+the key types apart.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 #define KEY_INDEX_MAX 4
 
 static inline word
 clean_index_key(word key)
-{ key &= ~((word)STG_GLOBAL);
-  if ( !key ) key = 1;
-  return key;
+{ return (key & ~((word)(TAG_MASK|STG_MASK))) | TAG_STRING|STG_GLOBAL;
 }
 
 static inline word
@@ -5931,6 +5931,8 @@ swi_statistics(DECL_LD atom_t key, Number v)
     v->value.f = GD->statistics.thread_cputime;
   } else if ( key == ATOM_threads_peak )
     v->value.i = GD->thread.peak_id;
+  else if ( key == ATOM_thread_local_saved )
+    v->value.i = saved_local_definitions(LD);
 #endif
   else if (key == ATOM_table_space_used)
   { alloc_pool *pool;
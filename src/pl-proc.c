@@ -71,7 +71,6 @@ finding source files, etc.
 static void	resetProcedure(Procedure proc, bool isnew);
 static atom_t	autoLoader(Definition def);
 static Procedure visibleProcedure(functor_t f, Module m);
-static void	freeClauseRef(ClauseRef cref);
 static bool	setDynamicDefinition_unlocked(Definition def, bool isdyn);
 static void	registerDirtyDefinition(Definition def);
 static void	unregisterDirtyDefinition(Definition def);
@@ -261,7 +260,8 @@ delayedDestroyDefinition(Definition def)
 
 void
 unallocDefinition(Definition def)
-{ if ( def->tabling )
+{ forgetIndexAdvice(def);
+  if ( def->tabling )
     freeHeap(def->tabling, sizeof(*def->tabling));
   if ( def->impl.any.args )
     freeHeap(def->impl.any.args, sizeof(arg_info)*def->functor->arity);
@@ -1227,7 +1227,7 @@ newClauseRef(Clause clause, word key)
 }
 
 
-static void
+void
 freeClauseRef(ClauseRef cref)
 { Clause cl = cref->value.clause;
 
@@ -1400,6 +1400,7 @@ ClauseRef
 assertDefinition(DECL_LD Definition def, Clause clause, ClauseRef where)
 { word key;
   ClauseRef cref;
+  prepared_keys pk;
 
   if ( !add_ssu_clause(def, clause) )
   { freeClause(clause);
@@ -1414,6 +1415,11 @@ assertDefinition(DECL_LD Definition def, Clause clause, ClauseRef where)
 
   clause->generation.created = max_generation(def);
   clause->generation.erased  = 1;
+  prepareClauseIndexKeys(def, clause, &pk);
+#if O_QUICKEN
+  if ( ison(def, P_QUICKENED) )
+    quickenClause(clause);
+#endif
 
   LOCKDEF(def);
   acquire_def(def);
@@ -1449,10 +1455,11 @@ assertDefinition(DECL_LD Definition def, Clause clause, ClauseRef where)
   if ( isoff(def, P_DYNAMIC|P_LOCKED_SUPERVISOR) ) /* see (*) above */
     freeCodesDefinition(def, true);
 
-  addClauseToIndexes(def, clause, where);
+  addClauseToIndexes(def, clause, where, &pk);
   release_def(def);
   DEBUG(CHK_SECURE, checkDefinition(def));
   UNLOCKDEF(def);
+  releasePreparedKeys(&pk);
 
   if ( unlikely(!!LD->transaction.generation) && def && ison(def, P_TRANSACT) )
   { if ( LD->transaction.generation < LD->transaction.gen_max )
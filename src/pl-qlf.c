@@ -43,6 +43,7 @@
 #include "pl-dbref.h"
 #include "pl-dict.h"
 #include "pl-funct.h"
+#include "pl-index.h"
 #include "pl-proc.h"
 #include "pl-util.h"
 #include "pl-modul.h"
@@ -128,11 +129,11 @@ Below is an informal description of the format of a `.qlf' file:
 <statement>	::=	'W' <string>			% include wic file
 		      | 'P' <XR/functor>		% predicate
 			    <flags>
-			    {<clause>} <pattern>
+			    {<clause>} [<indexes>] <pattern>
 		      |	'O' <XR/modulename>		% pred out of module
 			    <XR/functor>
 			    <flags>
-			    {<clause>} <pattern>
+			    {<clause>} [<indexes>] <pattern>
 		      | 'D'
 			<lineno>			% source line number
 			<term>				% directive
@@ -152,6 +153,14 @@ Below is an informal description of the format of a `.qlf' file:
 			    <is_fact>			% 0 or 1
 			    <#n subclause> <codes>
 		      | 'X'				% end of list
+<indexes>	::=	'J' <fixed>			% 0 or 1
+			    <#indexes> {<index>}
+<index>		::=	<#args> {<arg>}			% 1-based arguments
+			<ln_buckets> <is_list>		% see hash_hints
+			<speedup>			% double
+			<perfect>			% version >= 73
+<perfect>	::=	0				% no perfect hash
+		      | <#groups> <seed> {<displace>}	% see perfect_hash
 <XR>		::=	XR_REF     <num>		% XR id from table
 			XR_NIL				% []
 			XR_CONS				% functor of [_|_]
@@ -215,6 +224,7 @@ first. The last byte has its 0x80 mask set.
 #define V_H_INTEGER   257		/* Abstract various H_INT variations */
 #define V_B_INTEGER   258		/* Abstract various B_INT variations */
 #define V_A_INTEGER   259		/* Abstract various A_INT variations */
+#define V_H_CONST2    260		/* H_CONST2 as two XRs */
 
 #define PRED_SYSTEM	 0x01		/* system predicate */
 #define PRED_HIDE_CHILDS 0x02		/* hide my childs */
@@ -222,6 +232,8 @@ first. The last byte has its 0x80 mask set.
 #define PRED_MULTIFILE	 0x08		/* Multifile */
 #define PRED_DYNAMIC	 0x10		/* Dynamic */
 
+#define MAX_INDEX_HINTS	 16		/* Max saved indexes per predicate */
+
 #define CLAUSE_UNIT_CLAUSE 0x01
 #define CLAUSE_SSU_COMMIT  0x02
 #define CLAUSE_SSU_CHOICE  0x04
@@ -278,6 +290,7 @@ typedef struct wic_state
 
   int        saved_version;		/* Version saved */
   int	     obfuscate;			/* Obfuscate source */
+  int	     perfect_hash;		/* Save perfect hash indexes */
   int	     load_nesting;		/* Nesting level of loadPart() */
   qlf_state *load_state;		/* current load-state */
 
@@ -1403,6 +1416,67 @@ resolve_rlabel(vm_rlabel_state *state, unsigned int id, Code base, Clause clause
 }
 
 
+/* Load the  'J' record that restores the indexes that  were active on
+ * the predicate when it was saved.  See saveIndexHintsWic().
+ */
+
+static void
+loadIndexHints(wic_state *state, Definition def, int skip)
+{ IOSTREAM *fd = state->wicFd;
+  bool fixed = qlfGetUInt32(fd) != 0;
+  unsigned int count = qlfGetUInt32(fd);
+  hash_hints hints[MAX_INDEX_HINTS];
+  int nhints = 0;
+
+  for(unsigned int i=0; i<count; i++)
+  { hash_hints h = {0};
+    unsigned int nargs = qlfGetUInt32(fd);
+    bool valid = nargs > 0 && nargs <= MAX_MULTI_INDEX;
+
+    for(unsigned int a=0; a<nargs; a++)
+    { unsigned int arg = qlfGetUInt32(fd);
+
+      if ( arg == 0 || arg > MAXINDEXARG )
+	valid = false;			/* skip the hint, not just the arg */
+      else if ( a < MAX_MULTI_INDEX )
+	h.args[a] = (iarg_t)arg;
+    }
+    h.ln_buckets = qlfGetUInt32(fd)&0x1f;
+    h.list       = qlfGetUInt32(fd) != 0;
+    h.speedup    = (float)qlfGetDouble(fd);
+    if ( state->saved_version >= 73 )
+    { unsigned int groups = qlfGetUInt32(fd);
+
+      if ( groups )
+      { perfect_hash *ph = newPerfectHash(groups);
+
+	ph->seed = (uint64_t)qlfGetInt64(fd);
+	for(unsigned int g=0; g<groups; g++)
+	  ph->displace[g] = qlfGetUInt32(fd);
+	if ( (groups&(groups-1)) == 0 && !h.list && nargs == 1 )
+	  h.perfect = ph;
+	else
+	  freePerfectHash(ph);
+      }
+    }
+
+    if ( valid && nhints < MAX_INDEX_HINTS )
+      hints[nhints++] = h;
+    else if ( h.perfect )
+      freePerfectHash(h.perfect);
+  }
+
+  if ( !skip && isoff(def, P_FOREIGN|P_THREAD_LOCAL) )
+  { set_index_hints(def, hints, nhints, fixed);
+  } else
+  { for(int i=0; i<nhints; i++)
+    { if ( hints[i].perfect )
+	freePerfectHash(hints[i].perfect);
+    }
+  }
+}
+
+
 static void
 loadClauseFlags(wic_state *state, Clause cl, int skip)
 { unsigned int flags = qlfGetUInt32(state->wicFd);
@@ -1457,6 +1531,9 @@ loadPredicate(DECL_LD wic_state *state, int skip)
       case 'L':
 	loadInclude(state, false);
 	continue;
+      case 'J':
+	loadIndexHints(state, def, skip);
+	continue;
       case 'C':			/* next clause */
       { int has_dicts = 0;
 	tmp_buffer buf;
@@ -1528,6 +1605,34 @@ loadPredicate(DECL_LD wic_state *state, int skip)
 #endif
 	      continue;
 	    }
+	    case V_H_CONST2:		/* pack if both fit in this process */
+	    { word w[2];
+
+	      for(int i=0; i<2; i++)
+	      { w[i] = loadXR(state);
+		if ( isAtom(w[i]) && !isNil(w[i]) )
+		  PL_register_atom(word2atom(w[i]));
+	      }
+#ifdef O_CONST2
+	      if ( isConst32(w[0]) && isConst32(w[1]) )
+	      { addCode(encode(H_CONST2));
+		addCode(consts2code(w[0], w[1]));
+		continue;
+	      }
+#endif
+	      for(int i=0; i<2; i++)
+	      { if ( isNil(w[i]) )
+		{ addCode(encode(H_NIL));
+		} else if ( isAtom(w[i]) )
+		{ addCode(encode(H_ATOM));
+		  addCode(w[i]);
+		} else
+		{ addCode(encode(H_SMALLINT));
+		  addCode((scode)valInt(w[i]));
+		}
+	      }
+	      continue;
+	    }
 	  }
 
 	  if ( op >= I_HIGHEST )
@@ -1609,8 +1714,14 @@ loadPredicate(DECL_LD wic_state *state, int skip)
 		break;
 	      }
 	      case CA1_INTEGER:
-		addCode((code)qlfGetInt64(fd));
+	      { code c = (code)qlfGetInt64(fd);
+
+		if ( op == C_INLINE &&	/* generation of another process */
+		     c != INLINE_GEN_ANY )
+		  c = (code)GEN_INFINITE;
+		addCode(c);
 		break;
+	      }
 	      case CA1_VAR:
 	      case CA1_FVAR:
 	      case CA1_CHP:
@@ -1729,6 +1840,7 @@ loadPredicate(DECL_LD wic_state *state, int skip)
 	      exit(1);
 	    }
 	  }
+	  setClauseGuard(clause);
 	  if ( csf )
 	    csf->current_procedure = proc;
 
@@ -2880,6 +2992,14 @@ saveWicClause(wic_state *state, Clause clause)
 	qlfPutUInt32(vop, fd);
 	qlfPutInt64(v, fd);
 	continue;
+#ifdef O_CONST2
+      case H_CONST2:
+	qlfPutUInt32(V_H_CONST2, fd);
+	saveXR(state, code2const(*bp, 0));
+	saveXR(state, code2const(*bp, 1));
+	bp++;
+	continue;
+#endif
     }
 
     qlfPutUInt32(op, fd);
@@ -3026,10 +3146,64 @@ saveWicClause(wic_state *state, Clause clause)
 		*         COMPILATION           *
 		*********************************/
 
+/* Save the indexes of the predicate we are closing, such that loading
+ * restores them without re-assessing the clauses.  This notably avoids
+ * the JITI warmup after loading a saved state.  If the state is opened
+ * with perfect_hash(true), we add a perfect hash for single argument
+ * indexes of static predicates.  See perfectHashDefinition().
+ */
+
+static void
+saveIndexHintsWic(wic_state *state, Definition def)
+{ IOSTREAM *fd = state->wicFd;
+  hash_hints hints[MAX_INDEX_HINTS];
+  bool fixed;
+  int count;
+
+  if ( ison(def, P_FOREIGN|P_THREAD_LOCAL) )
+    return;
+
+  count = get_index_hints(def, hints, MAX_INDEX_HINTS, &fixed);
+  if ( count == 0 && !fixed )
+    return;
+
+  Sputc('J', fd);
+  qlfPutUInt32(fixed, fd);
+  qlfPutUInt32(count, fd);
+  for(int i=0; i<count; i++)
+  { hash_hints *h = &hints[i];
+    perfect_hash *ph = NULL;
+    int nargs;
+
+    if ( state->perfect_hash )
+      ph = perfectHashDefinition(def, h);
+
+    for(nargs=0; nargs < MAX_MULTI_INDEX && h->args[nargs]; nargs++)
+      ;
+    qlfPutUInt32(nargs, fd);
+    for(int a=0; a<nargs; a++)
+      qlfPutUInt32(h->args[a], fd);
+    qlfPutUInt32(h->ln_buckets, fd);
+    qlfPutUInt32(h->list, fd);
+    qlfPutDouble(h->speedup, fd);
+    if ( ph )
+    { qlfPutUInt32(ph->groups, fd);
+      qlfPutInt64((int64_t)ph->seed, fd);
+      for(unsigned int g=0; g<ph->groups; g++)
+	qlfPutUInt32(ph->displace[g], fd);
+      freePerfectHash(ph);
+    } else
+    { qlfPutUInt32(0, fd);
+    }
+  }
+}
+
+
 static void
 closePredicateWic(wic_state *state)
 { if ( state->currentPred )
-  { Sputc('X', state->wicFd);
+  { saveIndexHintsWic(state, state->currentPred);
+    Sputc('X', state->wicFd);
     state->currentPred = NULL;
   }
 }
@@ -3625,16 +3799,29 @@ PRED_IMPL("$qlf_module", 2, qlf_module, 0)
 		 *	NEW MODULE SUPPORT	*
 		 *******************************/
 
+/* Open a QLF file for writing.  The header records the absolute path
+ * of the file, which is used to relocate the source paths if the file
+ * is loaded from another directory.  If `as` is not 0, record this path
+ * instead.
+ */
+
 static wic_state *
-qlfOpen(term_t file)
+qlfOpen(term_t file, term_t as)
 { char *name;
   char *absname;
   char tmp[PATH_MAX];
   IOSTREAM *out;
   wic_state *state;
 
-  if ( !PL_get_file_name(file, &name, 0) ||
-       !(absname = AbsoluteFile(name, tmp, sizeof(tmp))) )
+  if ( !PL_get_file_name(file, &name, 0) )
+    return NULL;
+  if ( as )
+  { char *asname;
+
+    if ( !PL_get_file_name(as, &asname, 0) ||
+	 !(absname = AbsoluteFile(asname, tmp, sizeof(tmp))) )
+      return NULL;
+  } else if ( !(absname = AbsoluteFile(name, tmp, sizeof(tmp))) )
     return NULL;
 
   if ( !(out = Sopen_file(name, "wb" TRACK_POS)) )
@@ -4116,10 +4303,16 @@ PRED_IMPL("$qlf_end_part", 0, qlf_end_part, 0)
 }
 
 
+/** '$qlf_open'(+File, +As)
+ *
+ * Start writing QLF data to File.  The header records As as the path of
+ * the QLF file.  See qlfOpen().
+ */
+
 static
-PRED_IMPL("$qlf_open", 1, qlf_open, 0)
+PRED_IMPL("$qlf_open", 2, qlf_open, 0)
 { PRED_LD
-  wic_state *state = qlfOpen(A1);
+  wic_state *state = qlfOpen(A1, A2);
 
   if ( state )
   { state->parent = LD->qlf.write_state;
@@ -4208,6 +4401,7 @@ Write a header for a QLF-stream
 
 static const PL_option_t open_wic_options[] =
 { { ATOM_obfuscate,	    OPT_BOOL },
+  { ATOM_perfect_hash,	    OPT_BOOL },
   { NULL_ATOM,		    0 }
 };
 
@@ -4217,11 +4411,12 @@ PRED_IMPL("$open_wic", 2, open_wic, 0)
 { GET_LD
   IOSTREAM *fd;
   int obfuscate = false;
+  int perfect_hash = false;
 
   assert(V_LABEL > I_HIGHEST);
 
   if ( !PL_scan_options(A2, 0, "state_option", open_wic_options,
-			&obfuscate) )
+			&obfuscate, &perfect_hash) )
     return false;
 
   if ( PL_get_stream_handle(A1, &fd) )
@@ -4229,6 +4424,7 @@ PRED_IMPL("$open_wic", 2, open_wic, 0)
 
     memset(state, 0, sizeof(*state));
     state->obfuscate = obfuscate;
+    state->perfect_hash = perfect_hash;
     state->wicFd = fd;
     writeWicHeader(state);
     state->parent = LD->qlf.write_state;
@@ -4849,7 +5045,7 @@ BeginPredDefs(wic)
   PRED_DEF("$qlf_include",          5, qlf_include,          0)
   PRED_DEF("$qlf_dependency",       1, $qlf_dependency,      0)
   PRED_DEF("$qlf_end_part",	    0, qlf_end_part,	     0)
-  PRED_DEF("$qlf_open",		    1, qlf_open,	     0)
+  PRED_DEF("$qlf_open",		    2, qlf_open,	     0)
   PRED_DEF("$qlf_close",	    0, qlf_close,	     0)
   PRED_DEF("$qlf_assert_clause",    2, qlf_assert_clause,    0)
   PRED_DEF("$open_wic",		    2, open_wic,	     0)
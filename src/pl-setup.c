@@ -1531,6 +1531,7 @@ emptyStacks(void)
   emptyStack((Stack)&LD->stacks.argument);
 
   LD->mark_bar          = gTop;
+  LD->young_bar         = NULL;
   if ( lTop && gTop )
   { int i;
 
@@ -286,8 +286,8 @@ listSupervisor(Definition def)
 
       for(size_t arg=0; arg<arity; arg++)
       { if ( !mode_arg_is_unbound(def, arg) )
-	{ if ( arg1Key(pc1, &c[0]) &&
-	       arg1Key(pc2, &c[1]) &&
+	{ if ( arg1Key(pc1, h_void1, &c[0]) &&
+	       arg1Key(pc2, h_void2, &c[1]) &&
 	       ( (c[0] == ATOM_nil && c[1] == FUNCTOR_dot2) ||
 		 (c[1] == ATOM_nil && c[0] == FUNCTOR_dot2) ) )
 	  { Code codes = allocCodes(4);
@@ -317,6 +317,89 @@ listSupervisor(Definition def)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+argKeySupervisor() creates a supervisor for  predicates with two clauses
+where one clause has an atom, small integer or compound for some argument
+and the other has not, as in
+
+	count(0, ...) :- !, ...
+	count(N, ...) :- ...
+
+The code is
+
+	S_ARGKEY <arg> <key> <otherclause>
+
+This dispatches on the  type  of  the   argument  without  entering  the
+generic clause indexing for the common case where the argument is bound
+and does not match <key>.  Arguments with mode `-` are never considered
+and arguments with mode `+` (see meta_predicate/1) are preferred.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static bool
+argKeyClause(Code pc, int in_hvoid, word *key)
+{ if ( arg1Key(pc, in_hvoid, key) )
+    return (word)(code)*key == *key;
+
+  return false;
+}
+
+static Code
+argKeySupervisor(Definition def)
+{ size_t arity = def->functor->arity;
+
+  if ( def->impl.clauses.number_of_clauses == 2 && arity > 0 )
+  { ClauseRef cref[2];
+    int found = getClauses(def, cref, 2);
+
+    if ( found == 2 )
+    { Code pc1 = cref[0]->value.clause->codes;
+      Code pc2 = cref[1]->value.clause->codes;
+      int h_void1 = 0;
+      int h_void2 = 0;
+      int best = -1;
+      word bkey = 0;
+      ClauseRef bother = NULL;
+
+      for(size_t arg=0; arg<arity; arg++)
+      { if ( !mode_arg_is_unbound(def, arg) )
+	{ word k1, k2;
+	  bool has1 = argKeyClause(pc1, h_void1, &k1);
+	  bool has2 = argKeyClause(pc2, h_void2, &k2);
+
+	  if ( has1 != has2 &&
+	       ( best < 0 ||
+		 def->impl.any.args[arg].meta == MA_NONVAR ) )
+	  { best   = (int)arg;
+	    bkey   = has1 ? k1 : k2;
+	    bother = has1 ? cref[1] : cref[0];
+	    if ( def->impl.any.args[arg].meta == MA_NONVAR )
+	      break;
+	  }
+	}
+	pc1 = skipArgs(pc1, 1, &h_void1);
+	pc2 = skipArgs(pc2, 1, &h_void2);
+      }
+
+      if ( best >= 0 )
+      { Code codes = allocCodes(4);
+
+	DEBUG(1, Sdprintf("Argument key supervisor for %s\n",
+			  predicateName(def)));
+
+	codes[0] = encode(S_ARGKEY);
+	codes[1] = (code)best;
+	codes[2] = (code)bkey;
+	codes[3] = ptr2code(bother);
+
+	return codes;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+
 static Code
 dynamicSupervisor(Definition def)
 { if ( ison(def, P_DYNAMIC) )
@@ -366,10 +449,26 @@ copyCodes(Code dest, Code src, size_t count)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+catch/3 does not qualify its  arguments.  It  is  transparent, so  the
+context  module  of  its  frame  is  the  context  of  the caller, and
+I_CALL1 resolves both the goal and,  if an exception is caught, the
+recovery goal in this module.  This avoids creating two M:G terms and
+the context switch for each  call to catch/3.   shift/1 qualifies the
+recovery goal when it captures a catch/3 frame (see pl-cont.c).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static bool
+qualifyMetaArguments(Definition def)
+{ return ( ison(def, P_META) && ison(def, P_TRANSPARENT) &&
+	   !(PROCEDURE_catch3 && def == PROCEDURE_catch3->definition) );
+}
+
 static Code
 chainPredicateSupervisor(Definition def, Code post)
-{ if ( (ison(def, P_META) && ison(def, P_TRANSPARENT)) ||
-       ison(def, P_SSU_DET|P_DET) )
+{ bool qualify = qualifyMetaArguments(def);
+
+  if ( qualify || ison(def, P_SSU_DET|P_DET) )
   { tmp_buffer buf;
     Code codes;
 
@@ -380,7 +479,7 @@ chainPredicateSupervisor(Definition def, Code post)
     if ( ison(def, P_DET) )
       addBuffer(&buf, encode(S_DET), code);
 
-    if ( ison(def, P_META) && ison(def, P_TRANSPARENT) )
+    if ( qualify )
     { unsigned int i;
       int loffset = -1;
 
@@ -442,6 +541,7 @@ createSupervisor(Definition def)
 	       (codes = multifileSupervisor(def)) ||
 	       (codes = singleClauseSupervisor(def)) ||
 	       (codes = listSupervisor(def)) ||
+	       (codes = argKeySupervisor(def)) ||
 	       (codes = staticSupervisor(def)));
   assert(has_codes);
   (void)has_codes;
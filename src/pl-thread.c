@@ -7863,13 +7863,18 @@ free_ldef_vector(LocalDefinitions ldefs)
     if ( d0 )
       freeHeap(d0+bs, bs*sizeof(Definition));
   }
+  if ( ldefs->shared )
+    destroyDefinition(ldefs->shared);
+  if ( ldefs->index_hints )
+    freeHeap(ldefs->index_hints,
+	     MAX_LOCAL_INDEX_HINTS*sizeof(*ldefs->index_hints));
 
   freeHeap(ldefs, sizeof(*ldefs));
 }
 
 
-Definition
-localiseDefinition(DECL_LD Definition def)
+static Definition
+copyLocalDefinition(Definition def)
 { Definition local = allocHeapOrHalt(sizeof(*local));
   size_t bytes = sizeof(arg_info)*def->functor->arity;
 
@@ -7882,18 +7887,58 @@ localiseDefinition(DECL_LD Definition def)
   set(local, P_LOCALISED);
   local->impl.clauses.first_clause = NULL;
   local->impl.clauses.clause_indexes = NULL;
+  local->impl.clauses.range_indexes = NULL;
   ATOMIC_INC(&GD->statistics.predicates);
   ATOMIC_ADD(&local->module->code_size, sizeof(*local));
   DEBUG(MSG_PRED_COUNT, Sdprintf("Localise def[%d] %s at %p\n",
 				 PL_thread_self(), predicateName(def), local));
 
   setDefaultSupervisor(local);
-  registerLocalDefinition(def);
 
   return local;
 }
 
 
+Definition
+localiseDefinition(DECL_LD Definition def)
+{ Definition local = copyLocalDefinition(def);
+
+  seedLocalIndexes(local, def);
+  if ( !getProcDefinitionForThread(def, LD->thread.info->pl_tid) )
+    registerLocalDefinition(def);	/* else replaces the shared def */
+
+  return local;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+sharedLocalDefinition() returns the empty definition  that is shared by
+all threads that call  the  thread-local  predicate  `def'  without
+having clauses for it.  The caller stores it  in the slot of the calling
+thread, which avoids creating a local definition for threads that merely
+check the predicate.  As  the  shared  definition  has no clauses, it is
+never modified: localDefinition()  replaces  it  by  a  private  local
+definition as soon as the thread modifies the predicate.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+Definition
+sharedLocalDefinition(DECL_LD Definition def)
+{ LocalDefinitions v = def->impl.local.local;
+  Definition shared;
+
+  if ( !(shared=v->shared) )
+  { shared = copyLocalDefinition(def);
+    if ( !COMPARE_AND_SWAP_PTR(&v->shared, NULL, shared) )
+    { destroyDefinition(shared);
+      shared = v->shared;
+    }
+  }
+  registerLocalDefinition(def);
+
+  return shared;
+}
+
+
 void
 cleanupLocalDefinitions(PL_local_data_t *ld)
 { DefinitionChain ch = ld->thread.local_definitions;
@@ -7928,7 +7973,8 @@ sizeof_local_definitions(PL_local_data_t *ld)
     Definition local;
 
     assert(ison(def, P_THREAD_LOCAL));
-    if ( (local = getProcDefinitionForThread(def, ld->thread.info->pl_tid)) )
+    if ( (local = getProcDefinitionForThread(def, ld->thread.info->pl_tid)) &&
+	 local != def->impl.local.local->shared )
       size += sizeof_predicate(local);
   }
 
@@ -7936,6 +7982,30 @@ sizeof_local_definitions(PL_local_data_t *ld)
 }
 
 
+/* Memory saved by sharedLocalDefinition(): the size of the local
+ * definitions that are not created because the thread only called the
+ * predicate.  Used for thread_statistics(Id, thread_local_saved, Bytes).
+ */
+
+size_t
+saved_local_definitions(PL_local_data_t *ld)
+{ DefinitionChain ch = ld->thread.local_definitions;
+  size_t size = 0;
+
+  for( ; ch; ch = ch->next)
+  { Definition def = ch->definition;
+    Definition local;
+
+    if ( def &&
+	 (local = getProcDefinitionForThread(def, ld->thread.info->pl_tid)) &&
+	 local == def->impl.local.local->shared )
+      size += sizeof(*local) + sizeof(arg_info)*def->functor->arity;
+  }
+
+  return size;
+}
+
+
 
 /** '$thread_local_clause_count'(:Head, +Thread, -NumberOfClauses) is semidet.
 
@@ -518,6 +518,7 @@ static inline	PL_local_data_t *acquire_ldata(DECL_LD PL_thread_info_t *info);
 
 #if USE_LD_MACROS
 #define localiseDefinition(def)		LDFUNC(localiseDefinition, def)
+#define sharedLocalDefinition(def)	LDFUNC(sharedLocalDefinition, def)
 #define unify_thread_id(id, info)	LDFUNC(unify_thread_id, id, info)
 #endif /*USE_LD_MACROS*/
 #define LDFUNC_DECLARATIONS
@@ -539,6 +540,8 @@ void		executeThreadSignals(int sig);
 foreign_t	pl_attach_xterm(term_t in, term_t out);
 bool		attachConsole(void);
 Definition	localiseDefinition(Definition def);
+Definition	sharedLocalDefinition(Definition def);
+size_t		saved_local_definitions(PL_local_data_t *ld);
 LocalDefinitions new_ldef_vector(void);
 void		free_ldef_vector(LocalDefinitions ldefs);
 void		cleanupLocalDefinitions(PL_local_data_t *ld);
@@ -209,8 +209,8 @@ keyName(word key)
         case TAG_ATOM:
 	  strcpy(tmp, atom_summary(word2atom(key), 30));
 	  break;
-	case TAG_STRING:
-	  strcpy(tmp, string_summary(key, 30));
+	case TAG_STRING:		/* see clean_index_key() */
+	  Ssprintf(tmp, "<hash 0x%" PRIxPTR ">", (uintptr_t)key);
 	  break;
 	default:
 	  assert(0);
@@ -498,6 +498,43 @@ VMI(H_SMALLINTW, 0, CODES_PER_WORD, (CA1_WORD))
 }
 END_VMI
 
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+H_CONST2 unifies two subsequent arguments of the head with constants (an
+atom or small integer) that are packed in a single code (see consts2code()).
+This halves the code for facts with atomic arguments.  It is only used for
+arguments of the head itself and thus never runs in write mode.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+VMI(H_CONST2, 0, 1, (CA1_DATA2))
+{
+#ifdef O_CONST2
+  code c2 = *PC++;
+
+  ENSURE_GLOBAL_SPACE(0, (void)0);
+  for(int i=0; i<2; i++)
+  { word c = code2const(c2, i);
+    Word k = ARGP++;
+
+    if ( isAtom(c) )
+      pushVolatileAtom(word2atom(c));
+    deRef(k);
+    if ( *k == c )
+      continue;
+    if ( canBind(*k) )
+    { bindConst(k, c);
+      continue;
+    }
+    CLAUSE_FAILED;
+  }
+  NEXT_INSTRUCTION;
+#else
+  assert(0);
+  NEXT_INSTRUCTION;
+#endif
+}
+END_VMI
+
 VMH(h_const, 1, (word), (c))
 { Word k = ARGP;
 
@@ -1780,9 +1817,36 @@ If this frame has no alternatives it is possible to  put  the  backtrack
 frame  immediately  on  the backtrack frame of this frame.  This however
 makes debugging much more  difficult  as  the  system  will  do  a  deep
 backtrack without showing the fail ports explicitely.
+
+I_ENTER counts  how often the predicate's  clauses are entered.  After
+QUICKEN_THRESHOLD times,  quickenPredicate() rewrites the  clauses into
+specialised  instructions that  are  mapped  back  to  the  original
+instructions by decode().  I_ENTER itself becomes  I_ENTER_Q, so a hot
+predicate no longer pays for the counter.  If the predicate is already
+quickened, this is a clause that was added concurrently and we quicken
+just this clause.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 VMI(I_ENTER, VIF_BREAK, 0, ())
+{
+#if O_QUICKEN
+  Definition def = FR->predicate;
+
+  if ( likely(isoff(def, P_QUICKENED)) )
+  { if ( unlikely(ATOMIC_INC(&def->hot_count) >= QUICKEN_THRESHOLD) )
+    { SAVE_REGISTERS(QID);
+      quickenPredicate(def);
+      LOAD_REGISTERS(QID);
+    }
+  } else
+  { quickenClause(FR->clause->value.clause);
+  }
+#endif
+  VMI_GOTO(I_ENTER_Q);
+}
+END_VMI
+
+VMI(I_ENTER_Q, VIF_BREAK, 0, ())
 { ARGP = argFrameP(lTop, 0);
 
   if ( unlikely(LD->alerted) )
@@ -2415,19 +2479,22 @@ but we must not create a reference to   the B_VOID 0-variable. This is a
 simplified version of linkVal().
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
-VMI(L_VAR, 0, 2, (CA1_FVAR,CA1_VAR))
-{ Word v1 = varFrameP(FR, (size_t)*PC++);
-  Word v2 = varFrameP(FR, (size_t)*PC++);
-  word w = *v2;
-
-  while(isRef(w))
-  { v2 = unRef(w);
-    if ( needsRef(*v2) )
-      break;
-    w = *v2;
-  }
+#define L_VAR_MOVE() \
+	do \
+	{ Word v1 = varFrameP(FR, (size_t)*PC++); \
+	  Word v2 = varFrameP(FR, (size_t)*PC++); \
+	  word w = *v2; \
+	  while(isRef(w)) \
+	  { v2 = unRef(w); \
+	    if ( needsRef(*v2) ) \
+	      break; \
+	    w = *v2; \
+	  } \
+	  *v1 = w; \
+	} while(0)
 
-  *v1 = w;
+VMI(L_VAR, 0, 2, (CA1_FVAR,CA1_VAR))
+{ L_VAR_MOVE();
   NEXT_INSTRUCTION;
 }
 END_VMI
@@ -2548,6 +2615,25 @@ VMI(I_TCALL, 0, 0, ())
 
   VMH_GOTO(depart_or_retry_continue);
 }
+END_VMI
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+L_VAR_TCALL(to,from) and L_VAR_LCALL(to,from,proc) combine the last L_VAR
+of an LCO block with the I_TCALL or I_LCALL that ends it.  These pairs
+are amongst the most frequently executed.  Merging them saves a dispatch
+on each last call.  See initVMIMerge() in pl-comp.c.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+VMI(L_VAR_TCALL, 0, 2, (CA1_FVAR,CA1_VAR))
+{ L_VAR_MOVE();
+  VMI_GOTO(I_TCALL);
+}
+END_VMI
+
+VMI(L_VAR_LCALL, 0, 3, (CA1_FVAR,CA1_VAR,CA1_LPROC))
+{ L_VAR_MOVE();
+  VMI_GOTO(I_LCALL);
+}
 END_VMI
 
 		 /*******************************
@@ -2616,6 +2702,42 @@ VMI(C_JMP, 0, 1, (CA1_JUMP))
 END_VMI
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+C_INLINE starts a call that has been inlined by the compiler. The layout
+is
+
+	C_INLINE <jmp> <proc> <gen> <Inlined> C_JMP <n> <Call>
+
+where <Inlined> are the unifications and tests  of the single clause of
+<proc> and <Call> is the normal code to call <proc>. <gen> is the value
+of `last_modified` of the definition when the  call was inlined. If the
+predicate has been modified or wrapped  (see wrap_predicate/4) since, we
+are debugging or we are profiling we run <Call>.  <gen> is INLINE_GEN_ANY if <Inlined> is a direct call
+for a call/N goal in <Call>, which remains valid if <proc> is modified.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+VMI(C_INLINE, 0, 3, (CA1_JUMP,CA1_PROC,CA1_INTEGER))
+{ Definition def = code2ptr(Procedure, PC[1])->definition;
+
+  if ( likely(((code)def->last_modified == PC[2] &&
+	       def->codes[0] != encode(S_CALLWRAPPER)) ||
+	      PC[2] == INLINE_GEN_ANY) &&
+       !debugstatus.debugging
+#ifdef O_PROFILE
+       && !LD->profile.active
+#endif
+     )
+  { PC += 3;
+  } else
+  { PC += PC[0];
+    PC += 3;
+  }
+
+  NEXT_INSTRUCTION;
+}
+END_VMI
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 C_OR: Create choice-point in the clause.  Argument is the amount to skip
 if the choice-point needs to be activated.
@@ -3262,7 +3384,7 @@ VMI(S_VIRGIN, 0, 0, ())
       VMH_GOTO(depart_or_retry_continue);
 #ifdef O_PLMT
   } else if ( ison(DEF, P_THREAD_LOCAL) )
-  { DEF = getLocalProcDefinition(DEF);
+  { DEF = getLocalProcDefinitionForCall(DEF);
     setFramePredicate(FR, DEF);
     setGenerationFrame(FR);
 #endif
@@ -3362,7 +3484,10 @@ VMI(S_STATIC, 0, 0, ())
 
   DEBUG(9, Sdprintf("Searching clause ... "));
 
-  if ( !(cl = firstClause(ARGP, FR, DEF, &chp)) )
+  cl = firstClause(ARGP, FR, DEF, &chp);
+  if ( unlikely(guardedCandidates(cl, &chp)) )
+    cl = skipGuardedClauses(cl, ARGP, FR, DEF, &chp);
+  if ( !cl )
   { DEBUG(9, Sdprintf("No clause matching index.\n"));
     if ( debugstatus.debugging ||
 	 ison(FR, FR_SSU_DET|FR_DET|FR_DETGUARD) )
@@ -3417,7 +3542,7 @@ S_THREAD_LOCAL: Get thread-local definition
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 VMI(S_THREAD_LOCAL, 0, 0, ())
-{ DEF = getLocalProcDefinition(DEF);
+{ DEF = getLocalProcDefinitionForCall(DEF);
   setFramePredicate(FR, DEF);
   setGenerationFrame(FR);
 
@@ -3617,6 +3742,38 @@ VMI(S_LIST, 0, 3, (CA1_INTEGER, CA1_CLAUSEREF, CA1_CLAUSEREF))
 END_VMI
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+S_ARGKEY(ArgN, Key, Clause):
+Predicate consisting of two clauses, where one of them has the indexing
+key Key (an atom, small integer or functor) for argument ArgN (0-based).
+If ArgN is bound to a term with a different key, the clause with Key
+cannot match and we can trust the other clause, Clause.  Otherwise we
+use the generic S_STATIC.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+VMI(S_ARGKEY, 0, 3, (CA1_INTEGER, CA1_INTEGER, CA1_CLAUSEREF))
+{ ClauseRef cref;
+  Word k;
+  word w;
+
+  ARGP = argFrameP(FR, 0);
+  deRef2(ARGP+PC[0], k);
+  w = *k;
+  if ( isTerm(w) )
+    w = functorTerm(w);
+  if ( canBind(w) || w == (word)PC[1] )
+  { PC = SUPERVISOR(staticp) + 1;
+    VMI_GOTO(S_STATIC);
+  }
+
+  cref = code2ptr(ClauseRef, PC[2]);
+  PC += 3;
+
+  TRUST_CLAUSE(cref);
+}
+END_VMI
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Meta-predicate  argument  qualification.  S_MQUAL    qualifies  the  Nth
 argument. S_LMQUAL does the same and resets   the  context module of the
@@ -3725,6 +3882,66 @@ VMI(A_ENTER, 0, 0, ())
 }
 END_VMI
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A_ENTER_Q: Quickened A_ENTER  for a comparison  or `Var is A+B`/`Var is
+A*B` on two simple operands.  See quickenClause().  If the operands are
+tagged integers and the result fits, the  sequence is executed without
+using the  arithmetic stack.  Otherwise,  or  if  an  instruction was
+replaced by a breakpoint, we execute the generic sequence.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+VMI(A_ENTER_Q, 0, 0, ())
+{
+#if O_QUICKEN
+  sword i1, i2, r;
+  Code pc = PC;
+
+  if ( likely(!debugstatus.debugging) &&
+       quick_int_operand(&pc, FR, &i1) &&
+       quick_int_operand(&pc, FR, &i2) )
+  { int cmp;
+
+    switch(decode(*pc++))
+    { case A_LT: cmp = (i1 <  i2); break;
+      case A_LE: cmp = (i1 <= i2); break;
+      case A_GT: cmp = (i1 >  i2); break;
+      case A_GE: cmp = (i1 >= i2); break;
+      case A_EQ: cmp = (i1 == i2); break;
+      case A_NE: cmp = (i1 != i2); break;
+      case A_ADD:
+	if ( __builtin_add_overflow(i2, i1, &r) )
+	  goto a_enter_q_generic;
+	goto a_enter_q_is;
+      case A_MUL:
+	if ( __builtin_mul_overflow(i2, i1, &r) )
+	  goto a_enter_q_generic;
+      a_enter_q_is:
+	if ( decode(*pc) == A_FIRSTVAR_IS )
+	{ word w = consInt(r);
+
+	  if ( valInt(w) == r )
+	  { *varFrameP(FR, pc[1]) = w;
+	    PC = pc+2;
+	    NEXT_INSTRUCTION;
+	  }
+	}
+	goto a_enter_q_generic;
+      default:
+	goto a_enter_q_generic;
+    }
+
+    PC = pc;
+    if ( cmp )
+      NEXT_INSTRUCTION;
+    FASTCOND_FAILED;
+  }
+
+a_enter_q_generic:
+#endif
+  VMI_GOTO(A_ENTER);
+}
+END_VMI
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 A_INTEGER: Push long integer following PC
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -4004,6 +4221,89 @@ VMI(A_MUL, 0, 0, ())
 END_VMI
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A_FADD, A_FSUB, A_FMUL, A_FDIV: Float versions of +, -, * and /.  The
+compiler emits these if at least one operand is known to be a float,
+i.e., a float constant, the result of another float operation or float/1,
+or a variable that passed a float/1 test or is the result of a float
+expression.  This is a guess.  If one operand is a float and the other
+is a float or small integer, the result is computed directly on the
+arithmetic stack.  Otherwise we jump to the generic instruction.
+A_FSUB and A_FDIV carry the function index of -/2 and //2 such that they
+can use A_FUNC2 for the generic case.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define FLOAT_OPERANDS(n1, n2) \
+	( ((n1)->type == V_FLOAT && \
+	   ((n2)->type == V_FLOAT || (n2)->type == V_INTEGER)) || \
+	  ((n2)->type == V_FLOAT && (n1)->type == V_INTEGER) )
+#define FLOAT_VALUE(n) \
+	((n)->type == V_FLOAT ? (n)->value.f : (double)(n)->value.i)
+#define FLOAT_RESULT(argv, val) \
+	do \
+	{ (argv)->value.f = (val); \
+	  (argv)->type = V_FLOAT; \
+	  popArgvArithStack(1); \
+	  if ( unlikely(!isnormal((argv)->value.f) && (argv)->value.f != 0.0) ) \
+	  { int rc; \
+	    SAVE_REGISTERS(QID); \
+	    rc = check_float(argv); \
+	    LOAD_REGISTERS(QID); \
+	    if ( !rc ) \
+	      AR_THROW_EXCEPTION; \
+	  } \
+	  NEXT_INSTRUCTION; \
+	} while(0)
+
+VMI(A_FADD, 0, 0, ())
+{ Number argv = argvArithStack(2);
+
+  if ( FLOAT_OPERANDS(argv+1, argv) )
+    FLOAT_RESULT(argv, FLOAT_VALUE(argv+1) + FLOAT_VALUE(argv));
+
+  VMI_GOTO(A_ADD);
+}
+END_VMI
+
+VMI(A_FSUB, 0, 1, (CA1_AFUNC))
+{ Number argv = argvArithStack(2);
+
+  if ( FLOAT_OPERANDS(argv+1, argv) )
+  { PC++;
+    FLOAT_RESULT(argv, FLOAT_VALUE(argv+1) - FLOAT_VALUE(argv));
+  }
+
+  VMI_GOTO(A_FUNC2);
+}
+END_VMI
+
+VMI(A_FMUL, 0, 0, ())
+{ Number argv = argvArithStack(2);
+
+  if ( FLOAT_OPERANDS(argv+1, argv) )
+    FLOAT_RESULT(argv, FLOAT_VALUE(argv+1) * FLOAT_VALUE(argv));
+
+  VMI_GOTO(A_MUL);
+}
+END_VMI
+
+VMI(A_FDIV, 0, 1, (CA1_AFUNC))
+{ Number argv = argvArithStack(2);
+
+  if ( FLOAT_OPERANDS(argv+1, argv) )
+  { double d = FLOAT_VALUE(argv);
+
+    if ( isfinite(d) && d != 0.0 )	/* see ar_divide() */
+    { PC++;
+      FLOAT_RESULT(argv, FLOAT_VALUE(argv+1) / d);
+    }
+  }
+
+  VMI_GOTO(A_FUNC2);
+}
+END_VMI
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 A_ADD_FC: Simple case A is B + <int>, where   A is a firstvar and B is a
 normal variable. This case is very   common,  especially with relatively
@@ -6489,7 +6789,10 @@ VMH(shallow_backtrack, 0, (), ())
       NEXT_INSTRUCTION;
     } else if ( ch->type == CHP_CLAUSE )
     { ARGP = argFrameP(FR, 0);
-      if ( !(CL = nextClause(&ch->value.clause, ARGP, FR, DEF)) )
+      CL = nextClause(&ch->value.clause, ARGP, FR, DEF);
+      if ( unlikely(guardedCandidates(CL, &ch->value.clause)) )
+	CL = skipGuardedClauses(CL, ARGP, FR, DEF, &ch->value.clause);
+      if ( !CL )
 	FRAME_FAILED;		/* can happen if scan-ahead was too short */
       Word nTop = argFrameP(FR, CL->value.clause->variables);
       PC = CL->value.clause->codes;
@@ -6701,7 +7004,10 @@ next_choice:
       ARGP = argFrameP(FR, 0);
       DiscardMark(BFR->mark);
       BFR = BFR->parent;
-      if ( !(CL = nextClause(&chp, ARGP, FR, DEF)) )
+      CL = nextClause(&chp, ARGP, FR, DEF);
+      if ( unlikely(guardedCandidates(CL, &chp)) )
+	CL = skipGuardedClauses(CL, ARGP, FR, DEF, &chp);
+      if ( !CL )
 	goto next_choice;	  /* Can happen of look-ahead was too short */
 
       clause = CL->value.clause;
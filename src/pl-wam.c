@@ -69,6 +69,7 @@
 #include "pl-cont.h"
 #include "pl-coverage.h"
 #include <fenv.h>
+#include <math.h>
 #ifdef _MSC_VER
 #pragma warning(disable: 4102)		/* unreferenced labels */
 #endif
@@ -181,6 +182,26 @@ DbgPrintInstruction(LocalFrame FR, Code PC)
 
 #endif
 
+#ifdef O_VMI_PAIR_STATS
+/* Count the executed pairs of VM instructions.  This is enabled using
+ * the CMake option VMI_PAIR_STATS and used to find sequences that are
+ * worth merging into a single instruction (see initVMIMerge() in
+ * pl-comp.c).  The counts are shared and updated without locking.  The
+ * pairs are reported by '$vmi_pair_statistics'/2.
+ */
+
+uint64_t vmi_pair_counts[I_HIGHEST][I_HIGHEST];
+
+#define CountVMIPair(pc) \
+	do \
+	{ code _op = decode(*(pc)); \
+	  vmi_pair_counts[LD->vmi_stats.prev][_op]++; \
+	  LD->vmi_stats.prev = _op; \
+	} while(0)
+#else
+#define CountVMIPair(pc) (void)0
+#endif
+
 
 
 
@@ -1569,6 +1590,8 @@ __do_undo(DECL_LD const mark *m)
 
   Word ngtop = max(LD->frozen_bar, m->globaltop.as_ptr);
   reclaim_attvars(ngtop);
+  if ( LD->young_bar > ngtop )		/* see garbageCollect() */
+    LD->young_bar = ngtop;
 
   DEBUG(CHK_SECURE,
 	{ for(Word p = gTop; --p > ngtop;)
@@ -1599,11 +1622,9 @@ do_undo(mark *m)
 */
 
 #ifdef O_ENGINES
-#define localDefinition(def) LDFUNC(localDefinition, def)
-static Definition
-localDefinition(DECL_LD Definition def)
-{ unsigned int tid = LD->thread.info->pl_tid;
-  size_t idx = MSB(tid);
+static Definition *
+localDefinitionSlot(Definition def, unsigned int tid)
+{ size_t idx = MSB(tid);
   LocalDefinitions v = def->impl.local.local;
 
   if ( !v->blocks[idx] )
@@ -1618,10 +1639,19 @@ localDefinition(DECL_LD Definition def)
       PL_free(newblock);
   }
 
-  if ( !v->blocks[idx][tid] )
-    v->blocks[idx][tid] = localiseDefinition(def);
+  return &v->blocks[idx][tid];
+}
 
-  return v->blocks[idx][tid];
+#define localDefinition(def) LDFUNC(localDefinition, def)
+static Definition
+localDefinition(DECL_LD Definition def)
+{ Definition *slot = localDefinitionSlot(def, LD->thread.info->pl_tid);
+  Definition local = *slot;
+
+  if ( !local || local == def->impl.local.local->shared )
+    *slot = local = localiseDefinition(def);
+
+  return local;
 }
 
 void
@@ -1636,7 +1666,8 @@ destroyLocalDefinition(Definition def, unsigned int tid)
 
   local = v->blocks[idx][tid];
   v->blocks[idx][tid] = NULL;
-  destroyDefinition(local);
+  if ( local != v->shared )
+    destroyDefinition(local);
 }
 #endif
 
@@ -1654,6 +1685,34 @@ getLocalProcDefinition(DECL_LD Definition def)
 }
 
 
+/* As getLocalProcDefinition(), but used by the VM to call the predicate.
+ * If the thread has no clauses for the thread-local predicate, it runs
+ * the empty definition that is shared by all such threads.  See
+ * sharedLocalDefinition().
+ */
+
+Definition
+getLocalProcDefinitionForCall(DECL_LD Definition def)
+{
+#ifdef O_ENGINES
+  if ( ison(def, P_THREAD_LOCAL) )
+  { Definition *slot;
+
+    MEMORY_ACQUIRE();
+    if ( !truePrologFlag(PLFLAG_SHARED_THREAD_LOCAL) )
+      return localDefinition(def);
+
+    slot = localDefinitionSlot(def, LD->thread.info->pl_tid);
+    if ( !*slot )
+      *slot = sharedLocalDefinition(def);
+    return *slot;
+  }
+#endif
+
+  return def;
+}
+
+
 Definition
 getProcDefinitionForThread(Definition def, unsigned int tid)
 { size_t idx = MSB(tid);
@@ -1674,7 +1733,7 @@ getProcDefinedDefinition(DECL_LD Definition def)
 
 #ifdef O_PLMT
   if ( ison(def, P_THREAD_LOCAL) )
-    return getLocalProcDefinition(def);
+    return getLocalProcDefinitionForCall(def);
 #endif
 
   return def;
@@ -2485,6 +2544,50 @@ choice_type last_choice;
 #define Profile(g) (void)0
 #endif
 
+#if O_QUICKEN
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+quick_int_operand() decodes an arithmetic operand  instruction for the
+quickened A_ENTER_Q.  If the operand is a tagged integer, store it in *v,
+advance *pcp and return true.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define quick_int_operand(pcp, fr, v) LDFUNC(quick_int_operand, pcp, fr, v)
+static inline bool
+quick_int_operand(DECL_LD Code *pcp, LocalFrame fr, sword *v)
+{ Code PC = *pcp;
+  Word p;
+
+  switch(decode(*PC++))
+  { case A_VAR:
+      p = varFrameP(fr, *PC++);
+      break;
+    case A_VAR0:
+      p = varFrameP(fr, VAROFFSET(0));
+      break;
+    case A_VAR1:
+      p = varFrameP(fr, VAROFFSET(1));
+      break;
+    case A_VAR2:
+      p = varFrameP(fr, VAROFFSET(2));
+      break;
+    case A_INTEGER:
+      *v = (sword)*PC++;
+      *pcp = PC;
+      return true;
+    default:
+      return false;
+  }
+
+  deRef(p);
+  if ( !isTaggedInt(*p) )
+    return false;
+  *v = valInt(*p);
+  *pcp = PC;
+
+  return true;
+}
+#endif /*O_QUICKEN*/
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 {leave,discard}Frame()
      Exit from a frame.  leaveFrame() is used for normal leaving due to
@@ -3496,12 +3599,20 @@ static vmi_instr jmp_table[] =
 					goto helper_ ## n;
 #define _SOLUTION_RETURN		return
 
-#if VMCODE_IS_ADDRESS
+#if VMCODE_IS_ADDRESS || VMI_TOKEN_THREADING
 
+/* Each instruction ends in its own indirect jump to the next one, which
+ * gives the branch predictor a history per instruction.  With
+ * VMCODE_IS_ADDRESS the code holds the label address itself; with
+ * VMI_TOKEN_THREADING it holds the instruction number that is mapped
+ * through jmp_table[].
+ */
 #define _VMI_DECLARATION(Name,f,na,a)	Name ## _LBL:
 #define _NEXT_INSTRUCTION		DbgPrintInstruction(FR, PC); \
+					CountVMIPair(PC); \
 					_VMI_GOTO_CODE(*PC++)
 #define _VMI_GOTO(n)			goto n ## _LBL
+#if VMCODE_IS_ADDRESS
 #define _VMI_GOTO_CODE(c)		goto *code2ptr(void *, c)
 #undef SEPARATE_VMI1
 #undef SEPARATE_VMI2
@@ -3515,8 +3626,11 @@ static vmi_instr jmp_table[] =
 	{ if ( ++REGISTERS.nop1 == 0 ) separate_vmi(REGISTERS.nop1); }
 #define SEPARATE_VMI2 \
 	{ if ( ++REGISTERS.nop2 == 0 ) separate_vmi(REGISTERS.nop2); }
+#else /* VMI_TOKEN_THREADING */
+#define _VMI_GOTO_CODE(c)		goto *jmp_table[c]
+#endif /* VMCODE_IS_ADDRESS */
 
-#else /* VMCODE_IS_ADDRESS */
+#else /* VMCODE_IS_ADDRESS || VMI_TOKEN_THREADING */
 
 #if __GNUC__
 #define UNUSED_LABEL __attribute__ ((unused))
@@ -3529,7 +3643,7 @@ static vmi_instr jmp_table[] =
 #define _VMI_GOTO(n)			goto case_ ## n
 #define _VMI_GOTO_CODE(c)		thiscode = (c); goto resumebreak;
 
-#endif /* VMCODE_IS_ADDRESS */
+#endif /* VMCODE_IS_ADDRESS || VMI_TOKEN_THREADING */
 #endif /* O_VMI_FUNCTIONS */
 
 API_STUB(int)
@@ -3613,7 +3727,7 @@ pl-comp.c
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 
-#if VMCODE_IS_ADDRESS
+#if VMCODE_IS_ADDRESS || VMI_TOKEN_THREADING
 #undef VMI_IDENT
 #define VMI_IDENT(n) n ## _LBL
   static void *jmp_table[] =
@@ -3622,9 +3736,9 @@ pl-comp.c
     ),
     NULL
   };
-#else /* VMCODE_IS_ADDRESS */
+#else
 code thiscode;
-#endif /* VMCODE_IS_ADDRESS */
+#endif
 
 #endif /* O_VMI_FUNCTIONS */
 
@@ -3754,6 +3868,7 @@ initialised properly.
 #if O_VMI_FUNCTIONS
   for (;;)
   { DbgPrintInstruction(FR, PC);
+    CountVMIPair(PC);
 #if VMI_REGISTER_VARIABLES && !VMI_USE_REGISTER_VARIABLES
     DEBUG(0,
       assert(__reg_registers == &REGISTERS);
@@ -3767,9 +3882,10 @@ initialised properly.
 #endif
   }
 #else /* O_VMI_FUNCTIONS */
-#if !VMCODE_IS_ADDRESS			/* no goto *ptr; use a switch */
+#if !VMCODE_IS_ADDRESS && !VMI_TOKEN_THREADING	/* use a switch */
 next_instruction:
   DbgPrintInstruction(FR, PC);
+  CountVMIPair(PC);
   thiscode = *PC++;
 #ifdef O_DEBUGGER
 resumebreak:
@@ -47,6 +47,8 @@
 #if USE_LD_MACROS
 #define	TrailAssignment(p)		LDFUNC(TrailAssignment, p)
 #define	getLocalProcDefinition(def)	LDFUNC(getLocalProcDefinition, def)
+#define	getLocalProcDefinitionForCall(def) \
+	LDFUNC(getLocalProcDefinitionForCall, def)
 #define	PL_open_foreign_frame(_)	LDFUNC(PL_open_foreign_frame, _)
 #define	PL_close_foreign_frame(id)	LDFUNC(PL_close_foreign_frame, id)
 #define	PL_next_solution(qid)		LDFUNC(PL_next_solution, qid)
@@ -60,9 +62,13 @@
 #define LDFUNC_DECLARATIONS
 
 word		pl_count(void);
+#ifdef O_VMI_PAIR_STATS
+extern uint64_t	vmi_pair_counts[I_HIGHEST][I_HIGHEST];
+#endif
 void		TrailAssignment(Word p);
 void		do_undo(mark *m);
 Definition	getLocalProcDefinition(Definition def);
+Definition	getLocalProcDefinitionForCall(Definition def);
 Definition	getProcDefinitionForThread(Definition def, unsigned int tid);
 void		destroyLocalDefinition(Definition def, unsigned int tid);
 void		fix_term_ref_count(void);
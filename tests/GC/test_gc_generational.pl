@@ -0,0 +1,165 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           https://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+:- module(test_gc_generational,
+          [ test_gc_generational/0
+          ]).
+:- use_module(library(plunit)).
+:- use_module(library(lists)).
+:- use_module(library(apply)).
+
+/** <module> Test generational garbage collection
+
+If the flag `gc_generational` is  true,   most  collections only compact
+the global stack above the  stack  top  of   the  previous  GC.  These
+tests create old data, modify it  to   refer  to young data and verify
+the data is intact after many minor collections.
+*/
+
+test_gc_generational :-
+    run_tests([ gc_generational
+              ]).
+
+:- begin_tests(gc_generational,
+               [ setup(generational(true)),
+                 cleanup(generational(restore))
+               ]).
+
+%   Enable generational GC for the tests and restore the old value, as
+%   the suite may run with gc_generational set to true.
+
+generational(true) :-
+    current_prolog_flag(gc_generational, Old),
+    nb_setval(test_gc_generational, Old),
+    set_prolog_flag(gc_generational, true).
+generational(restore) :-
+    nb_getval(test_gc_generational, Old),
+    set_prolog_flag(gc_generational, Old).
+
+test(bind_old, N == 200) :-
+    T = t(_),
+    garbage_collect,                    % T is now old
+    churn(200 000, [], Acc),
+    arg(1, T, Acc),
+    churn(200 000, [], _),
+    T = t(L),
+    length(L, N),
+    assertion(maplist(==(1), L)).
+test(setarg, L == [a,b,c,d]) :-
+    T = t(0),
+    garbage_collect,
+    setarg_loop(100 000, T),
+    arg(1, T, L).
+test(nb_setarg, L == [a,b,c,d]) :-
+    T = t(0),
+    garbage_collect,
+    nb_setarg_loop(100 000, T),
+    arg(1, T, L).
+test(attvar, V == [a,b,c,d]-1) :-
+    put_attr(X, test_gc_generational, 0),
+    garbage_collect,
+    attr_loop(100 000, X),
+    get_attr(X, test_gc_generational, V).
+test(backtrack, Ss == [S,S,S]) :-
+    numlist(1, 10 000, L),
+    sum_list(L, S),
+    garbage_collect,
+    findall(S1,
+            ( between(1, 3, _),
+              churn(100 000, [], _),
+              sum_list(L, S1)
+            ), Ss).
+test(big_body, V == N) :-                % GC while writing a structure
+    N = 100 000,
+    trim_stacks,
+    link_clause(N, 0, V, Body),
+    call(Body).
+test(minor, Minor > Minor0) :-
+    '$gc_statistics'(_,_,_,_,_,Minor0,_),
+    length(Old, 10 000),
+    maplist(=(x), Old),
+    garbage_collect,
+    churn(500 000, [], _),
+    '$gc_statistics'(_,_,_,_,_,Minor,_),
+    assertion(length(Old, 10 000)).
+
+churn(0, Acc, Acc) :- !.
+churn(N, Acc0, Acc) :-
+    numlist(1, 20, L),
+    (   N mod 1000 =:= 0
+    ->  Acc1 = [1|Acc0]
+    ;   sum_list(L, _),
+        Acc1 = Acc0
+    ),
+    N1 is N-1,
+    churn(N1, Acc1, Acc).
+
+link_clause(1, V0, V, succ(V0, V)) :- !.
+link_clause(N, V0, V, (succ(V0, V1), G)) :-
+    N2 is N - 1,
+    link_clause(N2, V1, V, G).
+
+setarg_loop(0, _) :- !.
+setarg_loop(N, T) :-
+    numlist(1, 10, L0),
+    (   N == 1
+    ->  L = [a,b,c,d]
+    ;   L = L0
+    ),
+    setarg(1, T, L),
+    N1 is N-1,
+    setarg_loop(N1, T).
+
+nb_setarg_loop(0, _) :- !.
+nb_setarg_loop(N, T) :-
+    numlist(1, 10, L),
+    (   N mod 1000 =:= 1
+    ->  nb_setarg(1, T, [a,b,c,d])
+    ;   nb_setarg(1, T, L)
+    ),
+    N1 is N-1,
+    nb_setarg_loop(N1, T).
+
+attr_loop(0, _) :- !.
+attr_loop(N, X) :-
+    numlist(1, 10, L),
+    (   N == 1
+    ->  put_attr(X, test_gc_generational, [a,b,c,d]-N)
+    ;   put_attr(X, test_gc_generational, L-N)
+    ),
+    N1 is N-1,
+    attr_loop(N1, X).
+
+:- end_tests(gc_generational).
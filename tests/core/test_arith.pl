@@ -956,6 +956,83 @@ test(float_rval) :-
 test(float_rval) :-
 	6.5 is max(6.5,3).
 
+fexpr(X, Y) :-				% uses A_FMUL, A_FADD, etc.
+	Y is (X*0.5+1)/2.0 - X.
+fguard(X, Y) :-
+	float(X),
+	Y is X-1.
+fdiv(X, Y) :-
+	Y is 1.0/X.
+fmul(X, Y) :-
+	Y is X*1.0e300.
+
+test(float_ops, Y == -0.25) :-
+	fexpr(1.0, Y).
+test(float_ops, Y == -2.5) :-
+	fexpr(4, Y).
+test(float_ops) :-
+	fexpr(1r3, Y),
+	abs(Y-0.25) < 1.0e-10.
+test(float_ops, Y == 1.5) :-
+	fguard(2.5, Y).
+test(float_ops, fail) :-
+	fguard(2, _).
+test(float_ops, error(evaluation_error(zero_divisor))) :-
+	fdiv(0, _).
+test(float_ops, Y == 0.0) :-
+	fdiv(inf, Y).
+test(float_ops, error(evaluation_error(float_overflow))) :-
+	fmul(1.0e300, _).
+test(float_ops, Y == 1.0e300) :-
+	fmul(1, Y).
+
+qless(X, Y) :-				% A_ENTER is quickened when hot
+	X < Y.
+qadd(X, Y, Z) :-
+	Z0 is X+Y,
+	Z = Z0.
+qmul(X, Y, Z) :-
+	Z0 is X*Y,
+	Z = Z0.
+
+quicken :-
+	forall(between(1, 2000, I),
+	       ( qless(0, I), qadd(I, 1, _), qmul(I, 2, _) )).
+
+test(quicken, fail) :-
+	quicken,
+	qless(2, 1).
+test(quicken, Z == 9223372036854775806) :-
+	quicken,
+	qadd(4611686018427387903, 4611686018427387903, Z).
+test(quicken, Z == 21267647932558653957237540927630737409) :-
+	quicken,
+	qmul(4611686018427387903, 4611686018427387903, Z).
+test(quicken, Z == 4.5) :-
+	quicken,
+	qmul(3, 1.5, Z).
+test(quicken, error(instantiation_error)) :-
+	quicken,
+	qless(_, 1).
+
+:- dynamic qdyn/2.
+
+qdyn(X, Y) :-
+	Y is X+1.
+
+test(quicken_assert,
+     [ condition(current_predicate(system:'$clause_quickened'/1)),
+       cleanup(retractall(qdyn(_,_))),
+       Ys == [4,6]
+     ]) :-
+	forall(between(1, 2000, I), qdyn(I, _)),
+	clause(qdyn(_,_), _, Old),
+	'$clause_quickened'(Old),
+	assertz((qdyn(X, Y) :- Y is X*2)),
+	clause(qdyn(_,_), _ is _*2, New),
+	'$clause_quickened'(New),		% quickened by assertz/1
+	findall(Y, qdyn(3, Y), Ys).
+
 :- end_tests(arith_misc).
 
 % No tests below here because the set_prolog_flag(optimise, true) above
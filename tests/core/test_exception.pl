@@ -45,6 +45,7 @@ Please define a test-set for each predicate.
 
 test_exception :-
 	run_tests([ throw,
+		    catch,
 		    ex_coroutining
 		  ]).
 
@@ -69,6 +70,32 @@ test(cyclic, [ sto(rational_trees), setup(Ball = hello(Ball)),
 :- end_tests(throw).
 
 
+:- begin_tests(catch).
+
+% catch/3 does not qualify its arguments, but runs the goal and
+% recovery in the context module of the caller.
+
+ex_goal(ok).
+ex_recover(E, got(E)).
+
+test(context, X == ok) :-
+	catch(ex_goal(X), _, true).
+test(recover, R == got(x)) :-
+	catch(throw(x), E, ex_recover(E, R)).
+test(module, X-R == ok-got(x)) :-
+	assertz(test_exception_ctx:cg(ok)),
+	assertz(test_exception_ctx:rec(E, got(E))),
+	test_exception_ctx:catch(cg(X), _, true),
+	test_exception_ctx:catch(throw(x), E, rec(E, R)).
+test(qualified, R == got(x)) :-
+	catch(throw(x), E, test_exception:ex_recover(E, R)).
+test(shift, R == got(x)) :-
+	reset(catch((shift(s), throw(x)), E, ex_recover(E, R)), s, Cont),
+	test_exception_ctx:call(Cont).
+
+:- end_tests(catch).
+
+
 :- begin_tests(ex_coroutining).
 
 test(not, error(foo)) :-
@@ -0,0 +1,116 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           https://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(test_head_const,
+          [ test_head_const/0
+          ]).
+:- use_module(library(plunit)).
+:- use_module(library(lists)).
+:- use_module(library(apply)).
+
+/** <module> Test packed constants in the head
+
+On 64-bit systems, two subsequent  head   arguments  that are atoms or
+small integers are compiled into a single H_CONST2 instruction.  These
+tests verify that execution, indexing and decompilation are unaffected.
+*/
+
+test_head_const :-
+    run_tests([ head_const
+              ]).
+
+:- begin_tests(head_const).
+
+f(a, b, 3).
+f(c, d, 4).
+f(x, -5, []).
+f(y, 99999999999, z).                   % cannot be packed
+f(f(a,b), c, d).
+
+:- dynamic d/3.
+
+packed(Head) :-
+    clause(Head, _, Ref),
+    '$fetch_vm'(Ref, 0, _, VMI),
+    VMI = h_const2(_).
+
+test(call, L == [f(a,b,3),f(c,d,4),f(x,-5,[]),f(y,99999999999,z),
+                 f(f(a,b),c,d)]) :-
+    findall(f(A,B,C), f(A,B,C), L).
+test(packed, condition(current_prolog_flag(address_bits, 64))) :-
+    assertion(packed(f(a,_,_))),
+    assertion(packed(f(x,_,_))),
+    assertion(\+ packed(f(y,_,_))),
+    assertion(\+ packed(f(f(_,_),_,_))).
+test(arg2, X == c) :-
+    f(X, d, _).
+test(arg3, X-Y == x-(-5)) :-
+    f(X, Y, []).
+test(bind, X == 4) :-
+    f(c, d, X).
+test(fail, fail) :-
+    f(a, c, _).
+test(fail, fail) :-
+    f(c, 3, _).
+test(index_void_n, [ cleanup(retractall(d(_,_,_))),
+                     Det == true
+                   ]) :-                % skip H_VOID_N to the argument
+    forall(between(1, 100, I), assertz(d(_, _, I))),
+    d(_, _, 50),
+    call_cleanup(d(_, _, 60), Det = true).
+test(index_arg2, [ cleanup(retractall(d(_,_,_))),
+                   nondet,
+                   X == c
+                 ]) :-
+    forall(between(1, 100, I), assertz(d(I, I, I))),
+    assertz(d(c, d, e)),
+    d(X, d, _).
+test(clause, L == [f(a,b,3),f(c,d,4),f(x,-5,[]),f(y,99999999999,z),
+                   f(f(a,b),c,d)]) :-
+    findall(f(A,B,C), clause(f(A,B,C), true), L).
+test(assert, [ cleanup(retractall(d(_,_,_))),
+               L == [d(p,q,1),d(-1,[],r)]
+             ]) :-
+    retractall(d(_,_,_)),
+    assertz(d(p,q,1)),
+    assertz(d(-1,[],r)),
+    findall(d(A,B,C), d(A,B,C), L),
+    retract(d(p,q,1)).
+test(xref) :-
+    clause(f(c,_,_), true, Ref),
+    assertion('$xr_member'(Ref, d)),
+    findall(X, '$xr_member'(Ref, X), Xs),
+    assertion(subset([c,d], Xs)).
+
+:- end_tests(head_const).
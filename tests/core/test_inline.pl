@@ -0,0 +1,112 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2024, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(test_inline, [test_inline/0]).
+:- use_module(library(plunit)).
+
+/** <module> Test inlining of small predicates
+
+Clauses compiled while the flag `optimise` is `true` may have calls to
+small single-clause predicates expanded in place.  These tests verify
+that the result is indistinguishable from the normal call.
+*/
+
+test_inline :-
+    run_tests([ inline
+	      ]).
+
+:- begin_tests(inline).
+
+:- set_prolog_flag(optimise, true).
+
+x(p(X,_), X).
+pos(X) :- X > 0.
+
+get(T, X) :- x(T, X), pos(X).
+no_match(X) :- x(q(X), X).
+
+count(0, Acc, Acc) :- !.
+count(N, Acc0, Acc) :- x(p(N,_), X), Acc1 is Acc0+X, N1 is N-1,
+		       count(N1, Acc1, Acc).
+
+add(X, Y, Z) :- Z is X+Y.
+mc_closure(X, Z) :- call(add(1), X, Z).
+mc_goal(Z) :- call(add(1,2,Z)).
+mc_control(X) :- call((pos(X),!)).
+mc_redef(X) :- call(redef, X).
+
+:- dynamic redef/1.
+redef(old).
+
+dbl(X, Y) :- Y is X*2.
+dbl_call(X, Y) :- dbl(X, Y).
+
+:- set_prolog_flag(optimise, false).
+
+test(inlined, X == 3) :-
+    get(p(3,z), X).
+test(inlined, fail) :-
+    get(p(-3,z), _).
+test(no_match, fail) :-
+    no_match(_).
+test(loop, Acc == 5050) :-
+    count(100, 0, Acc).
+test(clause, Body == (x(T,X),pos(X))) :-
+    clause(get(T,X), Body).
+test(debug, X == 3) :-
+    setup_call_cleanup(
+	debug,
+	get(p(3,z), X),
+	nodebug).
+test(metacall, Z == 3) :-
+    mc_closure(2, Z).
+test(metacall, Z == 3) :-
+    mc_goal(Z).
+test(metacall, fail) :-
+    mc_control(-1).
+test(metacall, Body == call(add(1),X,Z)) :-
+    clause(mc_closure(X,Z), Body).
+test(metacall, X == new) :-
+    retractall(redef(_)),
+    assertz(redef(new)),
+    mc_redef(X).
+test(wrapped, fail) :-
+    setup_call_cleanup(
+	wrap_predicate(dbl(_,_), test_inline, _W, fail),
+	dbl_call(2, _),
+	unwrap_predicate(dbl(_,_), test_inline)).
+test(wrapped, Y == 4) :-
+    dbl_call(2, Y).
+
+:- end_tests(inline).
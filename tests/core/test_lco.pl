@@ -51,4 +51,56 @@ b(X, Y) :- X == Y.
 test(huub) :-
     a.
 
+% The last argument moves below are fused with the call into
+% L_VAR_TCALL and L_VAR_LCALL.
+
+count(Max, Max, N) :- !, N = Max.
+count(I, Max, N) :- I2 is I+1, count(I2, Max, N).
+
+loop(0, _, Acc, Acc) :- !.
+loop(N, X, Acc0, Acc) :- N1 is N-1, Acc1 is Acc0+X, loop2(N1, N, X, Acc1, Acc).
+
+loop2(N, _, X, Acc0, Acc) :- loop(N, X, Acc0, Acc).
+
+test(tcall, N == 100000) :-
+    count(0, 100000, N).
+test(lcall, Acc == 200000) :-
+    loop(100000, 2, 0, Acc).
+
+% Permuted arguments are moved in parallel, using a temporary
+% variable to break cycles.
+
+swap(0, A, B, A-B) :- !.
+swap(N, A, B, R) :- N1 is N-1, swap(N1, B, A, R).
+
+rot(0, A, B, C, r(A,B,C)) :- !.
+rot(N, A, B, C, R) :- N1 is N-1, rot(N1, B, C, A, R).
+
+mix(0, A, B, C, r(A,B,C)) :- !.
+mix(N, _, B, C, R) :- N1 is N-1, mix(N1, C, x, B, R).
+
+gc_swap(0, A, B, A-B) :- !.
+gc_swap(N, A, B, R) :-
+    N1 is N-1,
+    garbage_collect,
+    gc_swap(N1, B, f(A), R).
+
+% The callee has more arguments than the caller has variables.  The
+% temporary may not be one of the callee's argument slots.
+
+wide(A, B, C) :- N = n, wide(1, N, A, B, C).
+
+wide(1, n, a, b, c).
+
+test(swap, R == b-a) :-
+    swap(100001, a, b, R).
+test(rot, R == r(c,a,b)) :-
+    rot(100001, a, b, c, R).
+test(mix, R == r(x,x,x)) :-
+    mix(3, a, b, c, R).
+test(gc, R == f(b)-f(f(a))) :-
+    gc_swap(3, a, b, R).
+test(wide) :-
+    wide(a, b, c).
+
 :- end_tests(lco).
@@ -41,10 +41,12 @@
 :- use_module(library(debug)).
 :- use_module(library(apply)).
 :- use_module(library(lists)).
+:- use_module(library(thread)).
 
 test_jit :-
     run_tests([ jit,
-                jit_static
+                jit_static,
+                jit_guard
               ]).
 
 /** <module> Test unit for Just-In-Time indexing
@@ -131,6 +133,74 @@ test(midint, [cleanup(retractall(d(_,_)))]) :-
     test_index_2(mkbigint(60)).
 test(float, [cleanup(retractall(d(_,_)))]) :-
     test_index_2(mkfloat).
+test(bloom, [cleanup(retractall(d(_,_)))]) :-
+    forall((between(1,30,X), between(1,30,Y)), assertz(d(X,Y))),
+    d(3,4),
+    predicate_property(d(_,_), indexed([Index])),
+    assertion(Index.arguments == [1,2]),
+    assertion(number(Index.bloom)),
+    assertion(\+ d(3,31)),
+    assertz(d(_,31)),
+    assertion(d(3,31)).
+
+test(parallel_fill, [ cleanup(retractall(d(_,_))),
+                      Par == Seq
+                    ]) :-
+    fill_answers(Seq),
+    retractall(d(_,_)),
+    current_prolog_flag(ci_fill_min_clauses, Min),
+    current_prolog_flag(ci_fill_threads, Threads),
+    setup_call_cleanup(
+        ( set_prolog_flag(ci_fill_min_clauses, 100),
+          set_prolog_flag(ci_fill_threads, 4)
+        ),
+        fill_answers(Par),
+        ( set_prolog_flag(ci_fill_min_clauses, Min),
+          set_prolog_flag(ci_fill_threads, Threads)
+        )).
+test(parallel_fill_concurrent,
+     [ condition(current_prolog_flag(threads, true)),
+       cleanup(( retractall(d(_,_)),
+                 forall(member(P, [pd1,pd2,pd3,pd4]), abolish(P/2))
+               )),
+       Par == [Seq,Seq,Seq,Seq]
+     ]) :-			% fills share the helper threads
+    fill_answers(Seq),
+    current_prolog_flag(ci_fill_min_clauses, Min),
+    current_prolog_flag(ci_fill_threads, Threads),
+    setup_call_cleanup(
+        ( set_prolog_flag(ci_fill_min_clauses, 100),
+          set_prolog_flag(ci_fill_threads, 3)
+        ),
+        concurrent_maplist(fill_answers, [pd1,pd2,pd3,pd4], Par),
+        ( set_prolog_flag(ci_fill_min_clauses, Min),
+          set_prolog_flag(ci_fill_threads, Threads)
+        )).
+
+test(deep_shapes, [cleanup(retractall(d(_,_)))]) :-
+    forall(between(1,100,X),
+           (   X mod 2 =:= 0
+           ->  assertz(d(f(X,a),X))
+           ;   assertz(d(g(X,b,c),X))
+           )),
+    d(f(50,_),Y),
+    assertion(Y == 50),
+    predicate_property(d(_,_), indexed(Indexes)),
+    assertion((member(I1, Indexes), hash{arguments:[1], list:true} :< I1)),
+    assertion((member(I2, Indexes), hash{arguments:[1], position:[1]} :< I2)).
+
+test(advice, [ setup(set_prolog_flag(ci_sample, 1)),
+               cleanup(( set_prolog_flag(ci_sample, 0),
+                         '$index_advice'(_, true),
+                         retractall(d(_,_))
+                       ))
+             ]) :-
+    forall(between(1,100,X), assertz(d(X,a))),
+    forall(between(1,10,_), ignore(d(_,a))),
+    '$index_advice'(Advice, true),
+    assertion(memberchk(advice(test_jit:d/2, [2], 10, 1000, 100), Advice)),
+    '$index_advice'(Cleared, false),
+    assertion(\+ memberchk(advice(test_jit:d/2, _, _, _, _), Cleared)).
 
 rmd(X,Y) :-
     retract(d(X, Y)),
@@ -146,6 +216,31 @@ claused(X,Y) :-
     ;   true
     ).
 
+%   Fill a new index for d/2 and return the answers for all keys.
+%   Every 1000th clause has a variable first argument.
+
+fill_answers(Answers) :-
+    fill_answers(d, Answers).
+
+fill_answers(Name, Answers) :-
+    dynamic(Name/2),
+    forall(between(1, 5000, I),
+           (   K is I mod 997,
+               (   I mod 1000 =:= 0
+               ->  true
+               ;   A = K
+               ),
+               Clause =.. [Name, A, I],
+               assertz(Clause)
+           )),
+    findall(K-Is,
+            ( between(0, 997, K),
+              Goal =.. [Name, K, I],
+              findall(I, Goal, Is)
+            ), Answers),
+    Head =.. [Name, _, _],
+    assertion(has_hashes(Head, [1])).
+
 mkbigint(Shift, I, Big) :-
     Big is 1<<Shift+I.
 mkfloat(I, Float) :-
@@ -212,6 +307,13 @@ b(_,_,_,[_|_],_).
 pa(_, _).
 pa(_, x).
 
+k(0, zero).
+k(_, any).
+
+:- mode(km(?,+)).
+km(a, _).
+km(_, b).
+
 test(x) :-				% must use S_LIST
     x(_,_,_,_,[]).
 test(a) :-				% must use S_LIST (test H_VOID_N)
@@ -226,5 +328,105 @@ test(m) :-				% may not use S_LIST (test mode/1)
     !.
 test(pa) :-                             % primary index should be on arg 2
     pa(_,y).
+test(argkey, X == any) :-		% must use S_ARGKEY
+    k(1, X).
+test(argkey, all(X == [zero,any])) :-
+    k(0, X).
+test(argkey, all(Y == [zero,any])) :-
+    k(_, Y).
+test(argkey, fail) :-
+    k(f(0), zero).
+test(argkey_mode) :-			% must use S_ARGKEY on arg 2
+    km(a, c).
+test(argkey_mode, fail) :-
+    km(b, c).
+test(argkey_mode, all(X == [a,x])) :-
+    km(X, b),
+    (var(X) -> X = x ; true).
 
 :- end_tests(jit_static).
+
+:- begin_tests(jit_guard).
+
+:- dynamic
+    gd/2.
+
+max(X, Y, X) :- X >= Y.
+max(X, Y, Y) :- X < Y.
+
+type(X, int)  :- integer(X).
+type(X, atom) :- atom(X).
+type(X, comp) :- compound(X).
+
+eq(X, Y, same) :- X == Y.
+eq(X, Y, diff) :- X \== Y.
+
+bind(X, X) :- integer(X).
+bind(_, other).
+
+wake(X, a) :- integer(X).
+wake(_, b).
+
+occurs(X, f(X), Y) :- integer(Y).
+occurs(_, _, _).
+
+is_det(Goal) :-
+    call_cleanup(Goal, Det = true),
+    Det == true.
+
+test(max, M1-M2 == 3-3) :-
+    is_det(max(3, 2, M1)),
+    is_det(max(2, 3, M2)).
+test(max, error(instantiation_error)) :-
+    max(_, 3, _).
+test(type, L == [int,atom,comp]) :-
+    findall(T, (member(X, [1,a,f(x)]), is_det(type(X, T))), L).
+test(type, L == []) :-
+    findall(T, type(_, T), L).
+test(eq, L == [same,diff,same]) :-
+    is_det(eq(a, a, R1)),
+    is_det(eq(a, b, R2)),
+    is_det(eq(A, A, R3)),
+    L = [R1,R2,R3].
+test(eq, L == [diff]) :-
+    findall(R, eq(_, _, R), L).
+test(head_unify, L == [1]) :-           % guard before head unification
+    findall(A, bind(A, 1), L).
+test(occurs_check, error(occurs_check(_,_))) :- % may not skip clause 1
+    current_prolog_flag(occurs_check, Old),
+    setup_call_cleanup(
+        set_prolog_flag(occurs_check, error),
+        occurs(X, X, a),
+        set_prolog_flag(occurs_check, Old)).
+test(dynamic, [ cleanup(retractall(gd(_,_))),
+                L == [pos,neg,zero]
+              ]) :-
+    assertz((gd(X, pos) :- X > 0)),
+    assertz((gd(X, neg) :- X < 0)),
+    assertz(gd(0, zero)),
+    findall(S, (member(X, [1,-1,0]), is_det(gd(X, S))), L).
+test(optimise, [ cleanup(retractall(gd(_,_))),
+                 L == [pos,neg]
+               ]) :-
+    current_prolog_flag(optimise, Old),
+    setup_call_cleanup(
+        set_prolog_flag(optimise, true),
+        ( assertz((gd(X, pos) :- X >= 0)),
+          assertz((gd(X, neg) :- X < 0))
+        ),
+        set_prolog_flag(optimise, Old)),
+    findall(S, (member(X, [1,-1]), is_det(gd(X, S))), L).
+test(clause, N == 2) :-
+    aggregate_all(count, clause(max(_,_,_), _), N).
+
+test(wakeup, L == [a,b]) :-
+    retractall(gd(_,_)),
+    forall(( freeze(V, assertz(gd(woke, V))),
+             wake(foo, V)
+           ), true),
+    findall(W, retract(gd(woke, W)), L).
+test(wakeup, throws(woke(a))) :-
+    freeze(V, throw(woke(V))),
+    wake(foo, V).
+
+:- end_tests(jit_guard).
@@ -0,0 +1,88 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           https://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(test_accumulate, [test_accumulate/0]).
+:- use_module(library(plunit)).
+:- use_module(library(accumulate)).
+:- use_module(library(lists)).
+
+/** <module> Test accumulator introduction
+
+Test the clauses generated for predicates declared using accumulate/1.
+*/
+
+test_accumulate :-
+    run_tests([ accumulate
+              ]).
+
+:- accumulate len/2 as (+), prod/2 as (*), tsum/2 as (+), cnt/3 as (+).
+
+len([], 0).
+len([_|T], N) :- len(T, N0), N is N0+1.
+
+prod([], 1).
+prod([X|T], P) :- prod(T, P0), P is X*P0.
+
+tsum(leaf, 0).
+tsum(node(L,V,R), S) :- tsum(L, SL), tsum(R, SR), S is SL+V+SR.
+
+cnt([], _, 0).
+cnt([X|T], X, N) :- !, cnt(T, X, N0), N is N0+1.
+cnt([_|T], X, N) :- cnt(T, X, N).
+
+:- begin_tests(accumulate).
+
+test(len, N == 3) :-
+    len([a,b,c], N).
+test(len, fail) :-
+    len([a], 2).
+test(len, N == 1000000) :-
+    numlist(1, 1000000, L),
+    len(L, N).
+test(prod, P == 3628800) :-
+    numlist(1, 10, L),
+    prod(L, P).
+test(tree, S == 6) :-
+    tsum(node(node(leaf,1,leaf),2,node(leaf,3,leaf)), S).
+test(count, N == 3) :-
+    cnt([a,b,a,c,a], a, N).
+test(last_call, Body == ('len acc'(T, Acc1, N))) :-
+    clause('len acc'([_|T], Acc, N), (Acc1 is Acc+1, Body)).
+test(pass, Body == 'cnt acc'(T, X, Acc, N)) :-
+    clause('cnt acc'([_|T], X, Acc, N), Body),
+    \+ Body = (!,_).
+test(directive, error(domain_error(accumulate_operator, -))) :-
+    expand_term((:- accumulate(p/1 as (-))), _).
+
+:- end_tests(accumulate).
@@ -0,0 +1,79 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(test_range_index,
+          [ test_range_index/0
+          ]).
+:- use_module(library(plunit)).
+:- use_module(library(range_index)).
+
+test_range_index :-
+    run_tests([ range_index
+              ]).
+
+:- dynamic
+    price/2.
+
+price(1, 10).
+price(2, 150).
+price(3, 99.5).
+price(4, 100).
+price(5, abc).
+price(6, _).
+price(7, f(x)).
+price(8, 100.0).
+price(9, X) :- X = 120.
+
+:- begin_tests(range_index).
+
+test(numbers, Ids == [3,4,8,2,9]) :-
+    findall(Id, range_call(price(Id, _), 2, 99, 150), Ids).
+test(open_low, Ids == [1,3,4,8,6]) :-
+    findall(Id, range_call(price(Id, _), 2, _, 100), Ids).
+test(open_high, Ids == [5,7]) :-
+    findall(Id, range_call(price(Id, _), 2, a, _), Ids).
+test(no_limits, Len == 9) :-
+    findall(Id, range_call(price(Id, _), 2, _, _), Ids),
+    length(Ids, Len).
+test(update, Ids == [10,9]) :-
+    findall(Id, range_call(price(Id, _), 2, 101, 149), _),
+    assertz(price(10, 110)),
+    findall(Id, range_call(price(Id, _), 2, 101, 149), Ids),
+    retract(price(10, 110)).
+test(undefined, error(existence_error(procedure, _))) :-
+    range_call(no_such_predicate(_), 1, 1, 2).
+test(arg, error(domain_error(argument_index, 3))) :-
+    range_call(price(_,_), 3, 1, 2).
+
+:- end_tests(range_index).
@@ -0,0 +1,80 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+% Test that the JITI indexes of idx/2 that are created by the directive
+% below are saved with the state and restored as virtual indexes.
+
+idx(1, k1).
+idx(2, k2).
+idx(3, k3).
+idx(4, k4).
+idx(5, k5).
+idx(6, k6).
+idx(7, k7).
+idx(8, k8).
+idx(9, k9).
+idx(10, k10).
+idx(11, k11).
+idx(12, k12).
+idx(13, k13).
+idx(14, k14).
+idx(15, k15).
+idx(16, k16).
+idx(17, k17).
+idx(18, k18).
+idx(19, k19).
+idx(20, k20).
+idx(21, k21).
+idx(22, k22).
+idx(23, k23).
+idx(24, k24).
+idx(25, k25).
+idx(26, k26).
+idx(27, k27).
+idx(28, k28).
+idx(29, k29).
+idx(30, k30).
+
+:- idx(_, k10) -> true ; true.
+
+test_index :-
+	predicate_property(idx(_,_), indexed(Indexes)),
+	findall(Args-Realised,
+		( member(Index, Indexes),
+		  get_dict(arguments, Index, Args),
+		  get_dict(realised, Index, Realised)
+		), Pairs0),
+	msort(Pairs0, Pairs),
+	format('~q.~n', [Pairs]),
+	halt.
@@ -74,6 +74,15 @@ head(72057594037927936).
 head(-476462786578645564756252).
 head(476462786578645564756252).
 
+% Test H_CONST2: two subsequent constants in the head that fit in 32
+% bits are packed into a single instruction: 25 bit integers
+head2(16777215, -16777216).
+head2(16777216, -16777216).
+head2(-16777217, 16777215).
+head2(a, []).
+head2([], 0).
+head2(b, 72057594037927935).
+
 % test B_SMALLINT, B_SMALLINTW and B_MPZ
 % Push integer for subgoal
 body(X) :- echo(0, X).
@@ -141,6 +150,7 @@ rat(X) :- echo(-36r42, X).
 rat(X) :- X is 237r373 * 253r236.
 
 test(head(_)).
+test(head2(_,_)).
 test(body(_)).
 test(expr(_)).
 test(add(_)).
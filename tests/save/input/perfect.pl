@@ -0,0 +1,61 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+% Test that the state is saved with a perfect hash for the index on the
+% first argument of ph/2 if it is created with --perfect_hash=true.  The
+% keys are pseudo random integers that collide using the normal hash.
+
+term_expansion(ph_facts, Clauses) :-
+	set_random(seed(42)),
+	findall(ph(K, I),
+		( between(1, 2000, I),
+		  K is random(1<<40)
+		), Clauses).
+
+ph_facts.
+
+:- ph(0, _) -> true ; true.
+
+test_perfect :-
+	(   forall(ph(K, I), (ph(K, J), J == I))
+	->  Found = true
+	;   Found = false
+	),
+	predicate_property(ph(_,_), indexed(Indexes)),
+	member(Index, Indexes),
+	get_dict(arguments, Index, [1]),
+	get_dict(collisions, Index, Collisions),
+	format('~q.~n', [Found-Collisions]),
+	halt.
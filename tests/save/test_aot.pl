@@ -0,0 +1,170 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2026, University of Amsterdam
+                              VU University Amsterdam
+		              CWI, Amsterdam
+                              SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*/
+
+:- module(test_aot,
+          [ test_aot/0
+          ]).
+:- use_module(library(plunit)).
+:- use_module(library(readutil)).
+
+has_foreign_lib(Lib) :-
+    absolute_file_name(foreign(Lib), _,
+                       [ file_type(executable),
+                         file_errors(fail),
+                         access(read)
+                       ]).
+
+:- if(has_foreign_lib(process)).
+:- use_module(library(process)).
+:- use_module(library(filesex)).
+:- endif.
+
+/** <module> Test compiling Prolog files to shared objects
+
+Tests `swipl aot`, which embeds the QLF  data   of  a Prolog file in a
+shared object.  The `aot_c` tests only   generate  the C file and load
+the embedded QLF data, so they do not need a C compiler.
+*/
+
+test_aot :-
+    run_tests([ aot_c,
+                aot
+              ]).
+
+can_aot :-
+    has_foreign_lib(process),
+    current_prolog_flag(executable, Exe),
+    file_directory_name(Exe, Dir),
+    atom_concat(Dir, '/swipl-ld', Ld),
+    exists_file(Ld).
+
+:- begin_tests(aot_c).
+
+test(c_file, [ setup(aot_c_files(Dir, Src, C)),
+               cleanup(( delete_file(Src),
+                         catch(delete_file(C), _, true),
+                         delete_directory(Dir)
+                       )),
+               Result == [a-1,b-2]-3-Src
+             ]) :-
+    use_module(app(aot), []),
+    app_aot:aot(Src, [c(true), output(C)]),
+    unload_file(Src),                   % aot/2 loads Src
+    c_bytes(C, Bytes),
+    load_qlf_bytes(Src, Bytes),
+    findall(K-V, aot_c_mod:pair(K, V), Pairs),
+    aot_c_mod:sum(Sum),
+    findall(F, ( clause(aot_c_mod:pair(_,_), true, Ref),
+                 clause_property(Ref, file(F))
+               ), Files),
+    sort(Files, [File]),
+    Result = Pairs-Sum-File.
+
+:- end_tests(aot_c).
+
+aot_c_files(Dir, Src, C) :-
+    tmp_file(aot, Dir),
+    make_directory(Dir),
+    atom_concat(Dir, '/aot_c_mod.pl', Src),
+    write_test_module(Src, aot_c_mod),
+    tmp_file(aot_c_mod, C0),
+    file_name_extension(C0, c, C).
+
+%   Get the QLF data from the array in the generated C file.
+
+c_bytes(C, Bytes) :-
+    read_file_to_string(C, String, []),
+    split_string(String, "{}", "", [_, Array|_]),
+    split_string(Array, ",", " \n", Hex),
+    maplist(number_string, Bytes, Hex).
+
+%   Load the QLF data as the install function of the shared object does.
+%   Its stream is named after Src, so QLF loading relocates the source
+%   paths if Src is not in the directory of the QLF file in the header.
+
+load_qlf_bytes(Src, Bytes) :-
+    tmp_file(aot_qlf, Tmp),
+    setup_call_cleanup(
+        open(Tmp, write, Out, [type(binary)]),
+        maplist(put_byte(Out), Bytes),
+        close(Out)),
+    setup_call_cleanup(
+        open(Tmp, read, In, [type(binary)]),
+        ( set_stream(In, file_name(Src)),
+          load_files(user:Src, [stream(In), format(qlf)])
+        ),
+        ( close(In),
+          delete_file(Tmp)
+        )).
+
+:- begin_tests(aot, [condition(can_aot)]).
+
+test(load, [ setup(aot_files(Dir, Src, So)),
+             cleanup(( delete_directory_and_contents(Dir),
+                       catch(delete_file(So), _, true)
+                     )),
+             Result == [a-1,b-2]-3-Src-Files0
+           ]) :-
+    directory_files(Dir, Files0),
+    current_prolog_flag(executable, Exe),
+    process_create(Exe, [aot, '-o', file(So), file(Src)], []),
+    directory_files(Dir, Files),        % no temporary files in Dir
+    use_foreign_library(So),
+    findall(K-V, aot_test_mod:pair(K, V), Pairs),
+    aot_test_mod:sum(Sum),
+    predicate_property(aot_test_mod:pair(_,_), file(File)),
+    Result = Pairs-Sum-File-Files.
+
+:- end_tests(aot).
+
+aot_files(Dir, Src, So) :-
+    tmp_file(aot, Dir),
+    make_directory(Dir),
+    directory_file_path(Dir, 'aot_test_mod.pl', Src),
+    write_test_module(Src, aot_test_mod),
+    current_prolog_flag(shared_object_extension, Ext),
+    tmp_file(aot_test_mod, So0),
+    file_name_extension(So0, Ext, So).
+
+write_test_module(Src, Module) :-
+    setup_call_cleanup(
+        open(Src, write, Out),
+        format(Out,
+               ':- module(~q, [pair/2, sum/1]).~n~n\c
+                pair(a, 1).~n\c
+                pair(b, 2).~n~n\c
+                sum(S) :- pair(a, X), pair(b, Y), S is X+Y.~n', [Module]),
+        close(Out)).
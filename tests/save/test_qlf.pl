@@ -76,6 +76,16 @@ test(h_integer,
              [head(_)],
              Expected, Found),
     debug(qlf(result), '~q~n~q', [Expected, Found]).
+test(h_const2,
+     [ Found =@= Expected,
+       setup(test_files(integers, Prolog, Qlf)),
+       cleanup(catch(delete_file(Qlf), _, true))
+     ]) :-
+    qlf_trip(Prolog,
+             Qlf,
+             [head2(_,_)],
+             Expected, Found),
+    debug(qlf(result), '~q~n~q', [Expected, Found]).
 test(b_integer,
      [ Found =@= Expected,
        setup(test_files(integers, Prolog, Qlf)),
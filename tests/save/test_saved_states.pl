@@ -246,6 +246,21 @@ test(true, Result == [true]) :-
           run_state(Exe, [], Result)
         ),
         remove_state(Exe)).
+test(index_hints, Result == [[[1]-false, [2]-false]]) :-
+    state_output(4, Exe),
+    call_cleanup(
+        ( create_state('input/index.pl', Exe, ['-g', test_index]),
+          run_state(Exe, [], Result)
+        ),
+        remove_state(Exe)).
+test(perfect_hash, Result == [true-0]) :-
+    state_output(5, Exe),
+    call_cleanup(
+        ( create_state('input/perfect.pl', Exe,
+                       ['--perfect_hash=true', '-g', test_perfect]),
+          run_state(Exe, [], Result)
+        ),
+        remove_state(Exe)).
 
 :- end_tests(saved_state).
 
@@ -63,6 +63,39 @@ test(retractall) :-
     forall(between(1, 10, _),
            concurrent_retractall(100)).
 
+:- dynamic q/2.
+
+%   Concurrent assertz/1 on a predicate with indexes on both arguments.
+%   The clause keys are computed before the predicate is locked, so
+%   check that the indexes still find all clauses, in order.
+
+assert_q(T, N) :-
+    forall(between(1, N, I),
+           ( K is T*100000+I,
+             V is -K,
+             assertz(q(K, V)) )).
+
+create_assert_q(T, Id) :-
+    thread_create(assert_q(T, 1000), Id).
+
+test(concurrent_assert_indexed, cleanup(retractall(q(_,_)))) :-
+    assert_q(0, 1000),
+    q(500, _), q(_, -500),
+    predicate_property(q(_,_), indexed(Indexes)),
+    assertion((member(I1, Indexes), I1.arguments == [1])),
+    assertion((member(I2, Indexes), I2.arguments == [2])),
+    numlist(1, 4, Ts),
+    maplist(create_assert_q, Ts, Ids),
+    maplist(thread_join, Ids),
+    forall(member(T, [0|Ts]),
+           ( Low is T*100000+1, High is T*100000+1000,
+             findall(K, (q(K, _), between(Low, High, K)), Ks),
+             assertion(numlist(Low, High, Ks)),
+             forall(member(K, Ks),
+                    ( V is -K,
+                      assertion(findall(X, q(K, X), [V])),
+                      assertion(findall(X, q(X, V), [K])) )) )).
+
 :- end_tests(test_dynamic).
 
 
@@ -0,0 +1,130 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        jan@swi-prolog.org
+    WWW:           https://www.swi-prolog.org
+    Copyright (c)  2026, SWI-Prolog Solutions b.v.
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(test_shared_local,
+          [ test_shared_local/0
+          ]).
+:- use_module(library(plunit)).
+:- use_module(library(lists)).
+
+/** <module> Test sharing thread-local definitions
+
+Threads that call a thread-local predicate  for which they have no clauses
+share an empty definition.  Indexes created by one thread are added as
+virtual indexes to the local definitions that are created later.
+*/
+
+test_shared_local :-
+    run_tests([ shared_local
+              ]).
+
+:- begin_tests(shared_local).
+
+:- thread_local p/2, q/1.
+
+in_thread(Goal) :-
+    thread_create(Goal, Id, []),
+    thread_join(Id, Status),
+    assertion(Status == true).
+
+saved(Bytes) :-
+    thread_self(Me),
+    thread_statistics(Me, thread_local_saved, Bytes).
+
+call_only :-
+    \+ p(_, _),
+    \+ q(_),
+    saved(Bytes),
+    Bytes > 0.
+
+call_then_assert :-
+    \+ q(_),
+    saved(B0),
+    assertion(B0 > 0),
+    assertz(q(1)),
+    assertz(q(2)),
+    findall(X, q(X), Xs),
+    assertion(Xs == [1,2]),
+    saved(B1),
+    assertion(B1 < B0).
+
+not_shared :-
+    set_prolog_flag(shared_thread_local, false),
+    \+ q(_),
+    saved(Bytes),
+    Bytes == 0.
+
+fill(N) :-
+    forall(between(1, N, I), assertz(p(a, I))).
+
+indexes(Indexes) :-
+    (   predicate_property(p(_,_), indexed(Indexes))
+    ->  true
+    ;   Indexes = []
+    ).
+
+has_index(Args, Realised, Indexes) :-
+    member(Index, Indexes),
+    get_dict(arguments, Index, Args),
+    get_dict(realised, Index, Realised),
+    !.
+
+create_index :-
+    fill(50),
+    p(a, 25).
+
+use_index :-
+    fill(50),
+    indexes(Indexes),
+    assertion(has_index([2], false, Indexes)),
+    p(a, 30),
+    indexes(Indexes1),
+    assertion(has_index([2], true, Indexes1)),
+    findall(X, p(X, 40), Xs),
+    assertion(Xs == [a]).
+
+test(call) :-
+    in_thread(call_only).
+test(assert) :-
+    in_thread(call_then_assert).
+test(flag) :-
+    in_thread(not_shared).
+test(private) :-
+    in_thread(fill(10)),
+    in_thread(\+ p(_, _)).
+test(index) :-
+    in_thread(create_index),
+    in_thread(use_index).
+
+:- end_tests(shared_local).